@@ -0,0 +1,438 @@
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_sig.h"
+#include "zkp_proof.h"
+#include "zkp_accumulator.h"
+#include "zkp_internal.h"
+
+// Initializes the parts of an accumulator shared by accumulator_init and accumulator_read.
+void _accumulator_init(accumulator_t acc, pairing_ptr pairing, element_t g) {
+	sig_scheme_init(acc->scheme, 0, pairing, g);
+	acc->secret_key = NULL;
+	acc->public_key = new((type_ptr)acc->scheme->public_key_type);
+	element_init(acc->value, acc->scheme->G_type->field);
+	element_set(acc->value, acc->scheme->g);
+}
+
+void accumulator_init(accumulator_t acc, pairing_ptr pairing, element_t g) {
+	_accumulator_init(acc, pairing, g);
+	acc->secret_key = new((type_ptr)acc->scheme->secret_key_type);
+	sig_key_setup(acc->scheme, acc->secret_key, acc->public_key);
+}
+
+void accumulator_clear(accumulator_t acc) {
+	element_clear(acc->value);
+	if (acc->secret_key != NULL) delete((type_ptr)acc->scheme->secret_key_type, acc->secret_key);
+	delete((type_ptr)acc->scheme->public_key_type, acc->public_key);
+	sig_scheme_clear(acc->scheme);
+}
+
+// Changes the value of an accumulator by adding or removing values, recording each
+// change in updates if it is not NULL.
+void _accumulator_change(accumulator_t acc, int removed, int count, element_t* values, accumulator_update_t* updates) {
+	int i;
+	element_ptr s = get_element(acc->scheme->Z_type, get_item(acc->scheme->secret_key_type, acc->secret_key, 0));
+	element_t e; element_init(e, acc->scheme->Z_type->field);
+	if (updates == NULL) {
+
+		// V := V ^ ((s + y_0) * (s + y_1) * ...), or its inverse for removal
+		element_t product; element_init(product, acc->scheme->Z_type->field);
+		element_set1(product);
+		for (i = 0; i < count; i++) {
+			element_add(e, s, values[i]);
+			element_mul(product, product, e);
+		}
+		if (removed) element_invert(product, product);
+		element_pow_zn(acc->value, acc->value, product);
+		element_clear(product);
+	} else {
+		for (i = 0; i < count; i++) {
+
+			// V := V ^ (s + y_#), or V ^ (1 / (s + y_#)) for removal
+			element_add(e, s, values[i]);
+			if (removed) element_invert(e, e);
+			element_pow_zn(acc->value, acc->value, e);
+
+			updates[i]->removed = removed;
+			element_init(updates[i]->value, acc->scheme->Z_type->field);
+			element_set(updates[i]->value, values[i]);
+			element_init(updates[i]->result, acc->scheme->G_type->field);
+			element_set(updates[i]->result, acc->value);
+		}
+	}
+	element_clear(e);
+}
+
+void accumulator_add(accumulator_t acc, element_t value, accumulator_update_ptr update) {
+	_accumulator_change(acc, 0, 1, (element_t*)value, (accumulator_update_t*)update);
+}
+
+void accumulator_add_many(accumulator_t acc, int count, element_t* values, accumulator_update_t* updates) {
+	_accumulator_change(acc, 0, count, values, updates);
+}
+
+void accumulator_remove(accumulator_t acc, element_t value, accumulator_update_ptr update) {
+	_accumulator_change(acc, 1, 1, (element_t*)value, (accumulator_update_t*)update);
+}
+
+void accumulator_remove_many(accumulator_t acc, int count, element_t* values, accumulator_update_t* updates) {
+	_accumulator_change(acc, 1, count, values, updates);
+}
+
+void accumulator_update_clear(accumulator_update_t update) {
+	element_clear(update->value);
+	element_clear(update->result);
+}
+
+void accumulator_update_write(accumulator_t acc, accumulator_update_t update, FILE* stream) {
+	u64_write(update->removed, stream);
+	element_write(acc->scheme->Z_type->field, update->value, stream);
+	element_write(acc->scheme->G_type->field, update->result, stream);
+}
+
+int accumulator_update_read(accumulator_t acc, accumulator_update_t update, FILE* stream) {
+	uint64_t removed;
+	element_init(update->value, acc->scheme->Z_type->field);
+	element_init(update->result, acc->scheme->G_type->field);
+	if (u64_read(&removed, stream) != 8 || removed > 1 ||
+		element_read(acc->scheme->Z_type->field, update->value, stream) == 0 ||
+		element_read(acc->scheme->G_type->field, update->result, stream) == 0) {
+		accumulator_update_clear(update);
+		return 0;
+	}
+	update->removed = (int)removed;
+	return 1;
+}
+
+void accumulator_apply(accumulator_t acc, int count, accumulator_update_t* updates) {
+	if (count > 0) element_set(acc->value, updates[count - 1]->result);
+}
+
+void accumulator_witness(accumulator_t acc, element_t witness, element_t value) {
+	element_ptr s = get_element(acc->scheme->Z_type, get_item(acc->scheme->secret_key_type, acc->secret_key, 0));
+
+	// W = V ^ (1 / (s + y))
+	element_t e; element_init(e, acc->scheme->Z_type->field);
+	element_add(e, s, value);
+	element_invert(e, e);
+	element_pow_zn(witness, acc->value, e);
+	element_clear(e);
+}
+
+// Each update takes the witness W for y to W ^ a_# * B_# ^ b_#, where for adding y_#,
+// a_# = y_# - y, B_# = V_(# - 1) and b_# = 1, and for removing y_#, a_# = 1 / (y_# - y),
+// B_# = V_# and b_# = -a_#. The whole sequence therefore takes W to
+// W ^ (a_0 * a_1 * ...) * B_0 ^ (b_0 * a_1 * a_2 * ...) * B_1 ^ (b_1 * a_2 * ...) * ...,
+// whose exponents are computed from the last update back.
+int accumulator_update_witness(accumulator_t acc, element_t witness, element_t value,
+	int count, accumulator_update_t* updates) {
+	int i;
+	if (count == 0) return 1;
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (count + 1));
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (count + 1));
+	element_t *scalars = (element_t*)pbc_malloc(sizeof(element_t) * (count + 1));
+	for (i = 0; i <= count; i++) {
+		element_init(scalars[i], acc->scheme->Z_type->field);
+		exps[i] = scalars[i];
+	}
+	element_t a; element_init(a, acc->scheme->Z_type->field);
+	element_ptr suffix = exps[count];
+	element_set1(suffix);
+	for (i = count - 1; i >= 0; i--) {
+		element_sub(a, updates[i]->value, value);
+		if (updates[i]->removed) {
+			if (element_is0(a)) break;
+			element_invert(a, a);
+			element_neg(exps[i], a);
+			element_mul(exps[i], exps[i], suffix);
+			bases[i] = updates[i]->result;
+		} else {
+			element_set(exps[i], suffix);
+			bases[i] = i > 0 ? updates[i - 1]->result : acc->value;
+		}
+		element_mul(suffix, suffix, a);
+	}
+	int result = i < 0;
+	if (result) {
+		bases[count] = witness;
+		element_t temp; element_init_same_as(temp, witness);
+		element_multi_pow(temp, count + 1, bases, exps);
+		element_set(witness, temp);
+		element_clear(temp);
+	}
+	for (i = 0; i <= count; i++) element_clear(scalars[i]);
+	element_clear(a);
+	pbc_free(bases);
+	pbc_free(exps);
+	pbc_free(scalars);
+	return result;
+}
+
+int accumulator_verify(accumulator_t acc, element_t witness, element_t value) {
+	element_ptr P = get_element(acc->scheme->G_type, get_item(acc->scheme->public_key_type, acc->public_key, 0));
+	element_t PY; element_init(PY, acc->scheme->G_type->field);
+	element_t left; element_init(left, acc->scheme->T_type->field);
+	element_t right; element_init(right, acc->scheme->T_type->field);
+
+	// Verify <W, P * g ^ y> = <V, g>
+	element_pow_zn(PY, acc->scheme->g, value);
+	element_mul(PY, PY, P);
+	pairing_apply(left, witness, PY, acc->scheme->pairing);
+	pairing_apply(right, acc->value, acc->scheme->g, acc->scheme->pairing);
+	int result = !element_is1(witness) && !element_cmp(left, right);
+
+	element_clear(PY);
+	element_clear(left);
+	element_clear(right);
+	return result;
+}
+
+void accumulator_write(accumulator_t acc, FILE* stream) {
+	write((type_ptr)acc->scheme->public_key_type, acc->public_key, stream);
+	element_write(acc->scheme->G_type->field, acc->value, stream);
+}
+
+int accumulator_read(accumulator_t acc, pairing_ptr pairing, element_t g, FILE* stream) {
+	_accumulator_init(acc, pairing, g);
+	read((type_ptr)acc->scheme->public_key_type, acc->public_key, stream);
+	if (ferror(stream) || element_read(acc->scheme->G_type->field, acc->value, stream) == 0) {
+		accumulator_clear(acc);
+		return 0;
+	}
+	return 1;
+}
+
+
+/***************************************************
+* accumulated
+*
+* Verifies that a committed value is in a dynamic
+* accumulator, using a randomized witness.
+****************************************************/
+
+typedef struct block_accumulated_s *block_accumulated_ptr;
+typedef struct block_accumulated_s {
+	block_t base;
+	array_type_t claim_secret_type;
+	composite_type_t claim_public_type;
+	array_type_t response_type;
+	accumulator_ptr acc;
+	element_t value;
+	supplement_t witness;
+	long index;
+} block_accumulated_t[1];
+
+// e    	= challenge
+// <x, y>	= (bilinear pairing of x and y)
+// g     	= acc->scheme->g
+// s    	= s in secret key
+// P    	= P in public key	= g ^ s
+// V    	= self->value	= acc->value (when the block was built)
+
+// y	= inst->secret_values[index]
+// o	= inst->secret_openings[index]
+// C	= inst->secret_commitments[index]
+// W	= (witness supplement)	= V ^ (1 / (s + y))
+
+// r :: (proof->Z_type->field)
+// Wr	= W ^ r
+// Vr	= Wr ^ s	= Wr ^ -y * V ^ r
+
+// Wr is a random element of the group, so it reveals nothing about y, and <Wr, P> = <Vr, g>
+// shows that Vr = Wr ^ s. The remaining claims show knowledge of y and r with
+// Vr = Wr ^ -y * V ^ r and C = g ^ y * h ^ o, which together give Wr ^ (s + y) = V ^ r.
+
+// [r, r_y, r_r, r_o]	= (Wr, Vr, Wr ^ -r_y * V ^ r_r, g ^ r_y * h ^ r_o)
+// [y, r, o]        	= (Vr, C)
+
+void _accumulated_clear(block_ptr);
+int _accumulated_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _accumulated_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
+void _accumulated_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _accumulated_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _accumulated_response_verify_step(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr, int);
+block_accumulated_ptr block_accumulated(proof_t proof, accumulator_ptr acc, long index) {
+	sig_scheme_ptr scheme = acc->scheme;
+	block_accumulated_ptr self = (block_accumulated_ptr)pbc_malloc(sizeof(block_accumulated_t));
+	array_type_init(self->claim_secret_type, (type_ptr)proof->Z_type, 4);
+	composite_type_init(self->claim_public_type, 4, (type_ptr)scheme->G_type, (type_ptr)scheme->G_type,
+		(type_ptr)scheme->G_type, (type_ptr)proof->G_type);
+	array_type_init(self->response_type, (type_ptr)proof->Z_type, 3);
+	self->base->clear = &_accumulated_clear;
+	self->base->write = &_accumulated_write;
+	self->base->codegen = NULL;
+	self->base->claim_gen = &_accumulated_claim_gen;
+	self->base->response_gen = &_accumulated_response_gen;
+	self->base->response_verify = &_accumulated_response_verify;
+	self->base->response_verify_batch = NULL;
+	self->base->response_verify_step = &_accumulated_response_verify_step;
+	self->base->verify_steps = 3;
+	self->base->supplement_type = (type_ptr)scheme->G_type;
+	self->base->claim_secret_type = (type_ptr)self->claim_secret_type;
+	self->base->claim_public_type = (type_ptr)self->claim_public_type;
+	self->base->response_type = (type_ptr)self->response_type;
+	self->base->kind = BLOCK_ACCUMULATED;
+	self->acc = acc;
+	element_init_same_as(self->value, acc->value);
+	element_set(self->value, acc->value);
+	self->witness = proof->supplement_type.base->size;
+	self->index = index;
+	block_insert(proof, (block_ptr)self);
+	return self;
+}
+
+void _accumulated_clear(block_ptr block) {
+	block_accumulated_ptr self = (block_accumulated_ptr)block;
+	composite_type_clear(self->claim_public_type);
+	element_clear(self->value);
+	pbc_free(self);
+}
+
+int _accumulated_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_accumulated_ptr self = (block_accumulated_ptr)block;
+	int i;
+	for (i = 0; i < refs->num_accumulators; i++) {
+		if (refs->accumulators[i] == self->acc) break;
+	}
+	if (i == refs->num_accumulators) return 0;
+	u64_write(i, stream);
+	u64_write(self->index, stream);
+	return 1;
+}
+
+int block_accumulated_read(proof_t proof, proof_refs_t refs, FILE* stream) {
+	long ref, index;
+	if (!index_read(&ref, refs->num_accumulators, stream)) return 0;
+	if (!secret_index_read(proof, &index, stream)) return 0;
+	block_accumulated(proof, refs->accumulators[ref], index);
+	return 1;
+}
+
+void _accumulated_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
+	block_accumulated_ptr self = (block_accumulated_ptr)block;
+	accumulator_ptr acc = self->acc;
+	element_ptr W = get_element(acc->scheme->G_type, inst_supplement(proof, inst, self->witness));
+	element_ptr r = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 0));
+	element_ptr r_y = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 1));
+	element_ptr r_r = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 2));
+	element_ptr r_o = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 3));
+	element_ptr Wr = get_element(acc->scheme->G_type, get_part(self->claim_public_type, claim_public, 0));
+	element_ptr Vr = get_element(acc->scheme->G_type, get_part(self->claim_public_type, claim_public, 1));
+	element_ptr R_Vr = get_element(acc->scheme->G_type, get_part(self->claim_public_type, claim_public, 2));
+	element_ptr R_C = get_element(proof->G_type, get_part(self->claim_public_type, claim_public, 3));
+	element_ptr neg = inst->scratch_Z[0];
+
+	// Wr = W ^ r
+	element_random(r);
+	element_pow_zn(Wr, W, r);
+
+	// Vr = Wr ^ -y * V ^ r
+	element_neg(neg, inst->secret_values[self->index]);
+	element_pow2_zn(Vr, Wr, neg, self->value, r);
+
+	// R_Vr = Wr ^ -r_y * V ^ r_r
+	element_random(r_y);
+	element_random(r_r);
+	element_neg(neg, r_y);
+	element_pow2_zn(R_Vr, Wr, neg, self->value, r_r);
+
+	// R_C = g ^ r_y * h ^ r_o
+	element_random(r_o);
+	proof_pow_gh(proof, R_C, r_y, r_o);
+}
+
+void _accumulated_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
+	block_accumulated_ptr self = (block_accumulated_ptr)block;
+	element_ptr r = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 0));
+	element_ptr r_y = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 1));
+	element_ptr r_r = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 2));
+	element_ptr r_o = get_element(proof->Z_type, get_item(self->claim_secret_type, claim_secret, 3));
+	element_ptr x_y = get_element(proof->Z_type, get_item(self->response_type, response, 0));
+	element_ptr x_r = get_element(proof->Z_type, get_item(self->response_type, response, 1));
+	element_ptr x_o = get_element(proof->Z_type, get_item(self->response_type, response, 2));
+
+	// x_y = e * y + r_y
+	element_mul(x_y, challenge, inst->secret_values[self->index]);
+	element_add(x_y, x_y, r_y);
+
+	// x_r = e * r + r_r
+	element_mul(x_r, challenge, r);
+	element_add(x_r, x_r, r_r);
+
+	// x_o = e * o + r_o
+	element_mul(x_o, challenge, inst->secret_openings[self->index]);
+	element_add(x_o, x_o, r_o);
+}
+
+// Performs one of the three checks verifying an accumulated block. The checks are, in
+// order: the commitment, the randomized witness against Vr, and the pairing.
+int _accumulated_check(block_accumulated_ptr self, proof_t proof, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response, int step) {
+	accumulator_ptr acc = self->acc;
+	element_ptr x_y = get_element(proof->Z_type, get_item(self->response_type, response, 0));
+	element_ptr x_r = get_element(proof->Z_type, get_item(self->response_type, response, 1));
+	element_ptr x_o = get_element(proof->Z_type, get_item(self->response_type, response, 2));
+	element_ptr Wr = get_element(acc->scheme->G_type, get_part(self->claim_public_type, claim_public, 0));
+	element_ptr Vr = get_element(acc->scheme->G_type, get_part(self->claim_public_type, claim_public, 1));
+	element_ptr R_Vr = get_element(acc->scheme->G_type, get_part(self->claim_public_type, claim_public, 2));
+	element_ptr R_C = get_element(proof->G_type, get_part(self->claim_public_type, claim_public, 3));
+	int result;
+
+	if (step == 0) {
+		element_ptr left_G = inst->scratch_G[0];
+		element_ptr right_G = inst->scratch_G[1];
+
+		// Verify g ^ x_y * h ^ x_o = C ^ e * R_C
+		proof_pow_gh(proof, left_G, x_y, x_o);
+		element_pow_zn(right_G, inst->secret_commitments[self->index], challenge);
+		element_mul(right_G, right_G, R_C);
+		return !element_cmp(left_G, right_G);
+	}
+
+	if (step == 1) {
+		element_ptr neg = inst->scratch_Z[0];
+		element_t left; element_init(left, acc->scheme->G_type->field);
+		element_t right; element_init(right, acc->scheme->G_type->field);
+
+		// Verify Wr ^ -x_y * V ^ x_r = Vr ^ e * R_Vr
+		element_neg(neg, x_y);
+		element_pow2_zn(left, Wr, neg, self->value, x_r);
+		element_pow_zn(right, Vr, challenge);
+		element_mul(right, right, R_Vr);
+		result = !element_cmp(left, right);
+
+		element_clear(left);
+		element_clear(right);
+		return result;
+	}
+
+	// Verify Wr != 1 and <Wr, P> = <Vr, g>
+	if (element_is1(Wr)) return 0;
+	element_ptr P = get_element(acc->scheme->G_type, get_item(acc->scheme->public_key_type, acc->public_key, 0));
+	element_t left; element_init(left, acc->scheme->T_type->field);
+	element_t right; element_init(right, acc->scheme->T_type->field);
+	pairing_apply(left, Wr, P, acc->scheme->pairing);
+	pairing_apply(right, Vr, acc->scheme->g, acc->scheme->pairing);
+	result = !element_cmp(left, right);
+	element_clear(left);
+	element_clear(right);
+	return result;
+}
+
+int _accumulated_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	block_accumulated_ptr self = (block_accumulated_ptr)block;
+	int step;
+	for (step = 0; step < block->verify_steps; step++) {
+		if (!_accumulated_check(self, proof, inst, claim_public, challenge, response, step)) return 0;
+	}
+	return 1;
+}
+
+int _accumulated_response_verify_step(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response, int step) {
+	return _accumulated_check((block_accumulated_ptr)block, proof, inst, claim_public, challenge, response, step);
+}
+
+void require_accumulated(proof_t proof, accumulator_t acc, supplement_t* witness, var_t var) {
+	block_accumulated_ptr self = block_accumulated(proof, acc, var_secret_index(proof, var));
+	*witness = self->witness;
+}
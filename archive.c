@@ -0,0 +1,152 @@
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_internal.h"
+#include "zkp_archive.h"
+
+static const unsigned char archive_magic[4] = { 'Z', 'K', 'P', 'A' };
+static const uint32_t archive_version = 1;
+
+void _put_u64(unsigned char *data, uint64_t value) {
+	int i;
+	for (i = 0; i < 8; i++) data[i] = value >> (56 - 8 * i);
+}
+
+uint64_t _get_u64(const unsigned char *data) {
+	int i; uint64_t value = 0;
+	for (i = 0; i < 8; i++) value = (value << 8) | data[i];
+	return value;
+}
+
+void archive_writer_init(archive_writer_t writer, FILE* stream) {
+	unsigned char header[ARCHIVE_HEADER_SIZE];
+	writer->stream = stream;
+	writer->start = ftello(stream);
+	writer->count = 0;
+	writer->capacity = 16;
+	writer->index = (uint64_t*)pbc_malloc(sizeof(uint64_t) * 2 * writer->capacity);
+	
+	// Reserve space for the header, which is filled in once the index is known.
+	memset(header, 0, sizeof(header));
+	fwrite(header, 1, sizeof(header), stream);
+}
+
+void archive_writer_add(archive_writer_t writer, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	long i;
+	if (writer->count == writer->capacity) {
+		writer->capacity *= 2;
+		writer->index = (uint64_t*)pbc_realloc(writer->index, sizeof(uint64_t) * 2 * writer->capacity);
+	}
+	off_t offset = ftello(writer->stream);
+	element_write(proof->Z_type->field, challenge, writer->stream);
+	for (i = 0; i < proof->num_public; i++) {
+		element_write(proof->Z_type->field, inst->public_values[i], writer->stream);
+	}
+	inst_commitments_write(proof, inst, writer->stream);
+	write((type_ptr)&proof->claim_public_type, claim_public, writer->stream);
+	write((type_ptr)&proof->response_type, response, writer->stream);
+	writer->index[2 * writer->count + 0] = offset - writer->start;
+	writer->index[2 * writer->count + 1] = ftello(writer->stream) - offset;
+	writer->count++;
+}
+
+void archive_writer_clear(archive_writer_t writer) {
+	uint64_t i;
+	unsigned char entry[ARCHIVE_INDEX_ENTRY_SIZE];
+	unsigned char header[ARCHIVE_HEADER_SIZE];
+	
+	// Index: (offset, size) of each record.
+	off_t index_offset = ftello(writer->stream) - writer->start;
+	for (i = 0; i < writer->count; i++) {
+		_put_u64(entry + 0, writer->index[2 * i + 0]);
+		_put_u64(entry + 8, writer->index[2 * i + 1]);
+		fwrite(entry, 1, sizeof(entry), writer->stream);
+	}
+	off_t end = ftello(writer->stream);
+	
+	// Header: magic, version, record count, index offset, reserved.
+	memset(header, 0, sizeof(header));
+	memcpy(header, archive_magic, 4);
+	header[4] = archive_version >> 24;
+	header[5] = archive_version >> 16;
+	header[6] = archive_version >> 8;
+	header[7] = archive_version >> 0;
+	_put_u64(header + 8, writer->count);
+	_put_u64(header + 16, index_offset);
+	fseeko(writer->stream, writer->start, SEEK_SET);
+	fwrite(header, 1, sizeof(header), writer->stream);
+	fseeko(writer->stream, end, SEEK_SET);
+	fflush(writer->stream);
+	pbc_free(writer->index);
+}
+
+int archive_open(archive_t archive, const char* path) {
+	struct stat info;
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) return 0;
+	if (fstat(fileno(file), &info) < 0 || info.st_size < ARCHIVE_HEADER_SIZE) {
+		fclose(file);
+		return 0;
+	}
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fileno(file), 0);
+	fclose(file);
+	if (data == MAP_FAILED) return 0;
+	archive->data = (const unsigned char*)data;
+	archive->size = info.st_size;
+	
+	// Validate header.
+	const unsigned char *header = archive->data;
+	uint32_t version = (header[4] << 24) | (header[5] << 16) | (header[6] << 8) | (header[7] << 0);
+	uint64_t count = _get_u64(header + 8);
+	uint64_t index_offset = _get_u64(header + 16);
+	if (memcmp(header, archive_magic, 4) || version != archive_version ||
+		index_offset < ARCHIVE_HEADER_SIZE || index_offset > archive->size ||
+		count > (archive->size - index_offset) / ARCHIVE_INDEX_ENTRY_SIZE) {
+		archive_close(archive);
+		return 0;
+	}
+	archive->count = count;
+	archive->index = archive->data + index_offset;
+	return 1;
+}
+
+void archive_close(archive_t archive) {
+	munmap((void*)archive->data, archive->size);
+}
+
+int archive_read(archive_t archive, uint64_t record, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	long i;
+	if (record >= archive->count) return 0;
+	uint64_t offset = _get_u64(archive->index + ARCHIVE_INDEX_ENTRY_SIZE * record);
+	uint64_t size = _get_u64(archive->index + ARCHIVE_INDEX_ENTRY_SIZE * record + 8);
+	if (offset < ARCHIVE_HEADER_SIZE || offset > archive->size || size > archive->size - offset) return 0;
+	const unsigned char *bytes = archive->data + offset;
+	
+	size_t len = element_read_bytes(proof->Z_type->field, challenge, bytes, size);
+	if (read_failed(len)) return 0;
+	bytes += len; size -= len;
+	for (i = 0; i < proof->num_public; i++) {
+		len = element_read_bytes(proof->Z_type->field, inst->public_values[i], bytes, size);
+		if (read_failed(len)) return 0;
+		bytes += len; size -= len;
+	}
+	inst_invalidate(proof, inst);
+	for (i = 0; i < proof->num_secret; i++) {
+		if (!secret_committed(proof, i)) continue;
+		len = element_read_bytes(proof->G_type->field, inst->secret_commitments[i], bytes, size);
+		if (read_failed(len)) return 0;
+		bytes += len; size -= len;
+	}
+	len = read_bytes((type_ptr)&proof->claim_public_type, claim_public, bytes, size);
+	if (read_failed(len)) return 0;
+	bytes += len; size -= len;
+	len = read_bytes((type_ptr)&proof->response_type, response, bytes, size);
+	if (read_failed(len)) return 0;
+	
+	// The record must end with the response.
+	return len == size;
+}
@@ -0,0 +1,124 @@
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_arena.h"
+
+// The alignment of all data allocated from an arena.
+#define ARENA_ALIGN 16
+
+typedef struct arena_chunk_s {
+	struct arena_chunk_s *next;
+	size_t size;
+	size_t used;
+	char *data;
+} arena_chunk_t;
+
+typedef struct arena_entry_s {
+	type_ptr type;
+	size_t count;
+	data_ptr data;
+	
+	// The chunk the data was allocated from, and how much of it was used before.
+	arena_chunk_t *chunk;
+	size_t mark;
+} arena_entry_t;
+
+void arena_init(arena_t arena, size_t chunk_size) {
+	arena->chunk_size = chunk_size;
+	arena->first_chunk = NULL;
+	arena->current_chunk = NULL;
+	arena->entries = NULL;
+	arena->count = 0;
+	arena->capacity = 0;
+	arena->next = 0;
+}
+
+void _arena_truncate(arena_t arena, int count);
+void arena_clear(arena_t arena) {
+	_arena_truncate(arena, 0);
+	arena_chunk_t *current = arena->first_chunk;
+	while (current != NULL) {
+		arena_chunk_t *next = current->next;
+		pbc_free(current->data);
+		pbc_free(current);
+		current = next;
+	}
+	if (arena->entries != NULL) pbc_free(arena->entries);
+}
+
+void arena_reset(arena_t arena) {
+	arena->next = 0;
+}
+
+// Clears all entries from the given index onwards and rewinds the chunks to where the
+// first of them was allocated.
+void _arena_truncate(arena_t arena, int count) {
+	int i; size_t j;
+	if (count >= arena->count) return;
+	for (i = arena->count - 1; i >= count; i--) {
+		arena_entry_t *entry = &arena->entries[i];
+		for (j = 0; j < entry->count; j++) {
+			clear(entry->type, (data_ptr)((char*)entry->data + j * entry->type->size));
+		}
+	}
+	arena_entry_t *first = &arena->entries[count];
+	arena_chunk_t *chunk;
+	for (chunk = first->chunk->next; chunk != NULL; chunk = chunk->next) chunk->used = 0;
+	first->chunk->used = first->mark;
+	arena->current_chunk = first->chunk;
+	arena->count = count;
+}
+
+data_ptr arena_new(arena_t arena, type_ptr type) {
+	return arena_new_array(arena, type, 1);
+}
+
+data_ptr arena_new_array(arena_t arena, type_ptr type, size_t count) {
+	size_t i;
+	if (arena->next < arena->count) {
+		arena_entry_t *entry = &arena->entries[arena->next];
+		if (entry->type == type && entry->count == count) {
+			arena->next++;
+			return entry->data;
+		}
+		_arena_truncate(arena, arena->next);
+	}
+	
+	// Find space in the current chunk or a later one, adding a chunk if none fits.
+	size_t size = (type->size * count + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	arena_chunk_t *chunk = arena->current_chunk;
+	while (chunk != NULL && chunk->used + size > chunk->size) {
+		chunk = chunk->next;
+		if (chunk != NULL) chunk->used = 0;
+	}
+	if (chunk == NULL) {
+		chunk = (arena_chunk_t*)pbc_malloc(sizeof(arena_chunk_t));
+		chunk->size = size > arena->chunk_size ? size : arena->chunk_size;
+		chunk->used = 0;
+		chunk->data = (char*)pbc_malloc(chunk->size);
+		chunk->next = NULL;
+		if (arena->current_chunk == NULL) {
+			arena->first_chunk = chunk;
+		} else {
+			arena_chunk_t *last = arena->current_chunk;
+			while (last->next != NULL) last = last->next;
+			last->next = chunk;
+		}
+	}
+	arena->current_chunk = chunk;
+	
+	if (arena->count == arena->capacity) {
+		arena->capacity = arena->capacity > 0 ? arena->capacity * 2 : 16;
+		arena->entries = (arena_entry_t*)pbc_realloc(arena->entries, sizeof(arena_entry_t) * arena->capacity);
+	}
+	arena_entry_t *entry = &arena->entries[arena->count++];
+	entry->type = type;
+	entry->count = count;
+	entry->chunk = chunk;
+	entry->mark = chunk->used;
+	entry->data = (data_ptr)(chunk->data + chunk->used);
+	chunk->used += size;
+	for (i = 0; i < count; i++) init(type, (data_ptr)((char*)entry->data + i * type->size));
+	arena->next = arena->count;
+	return entry->data;
+}
@@ -0,0 +1,124 @@
+#include <assert.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_internal.h"
+#include "zkp_batch.h"
+
+void batch_init(batch_t batch, proof_t proof, int count) {
+	long i; int j;
+	assert(proof->plan != NULL);
+	batch->proof = proof;
+	batch->count = count;
+	
+	// All elements are held in one run: commitments, then public values, then challenges
+	// and scratch space.
+	long num_secret = proof->num_secret, num_public = proof->num_public;
+	element_t *run = (element_t*)pbc_malloc(sizeof(element_t) * ((num_secret + num_public + 1) * count + 2 * INST_SCRATCH));
+	batch->secret_commitments = (element_t**)pbc_malloc(sizeof(element_t*) * (num_secret + num_public + 1));
+	batch->public_values = batch->secret_commitments + num_secret;
+	for (i = 0; i < num_secret; i++) {
+		batch->secret_commitments[i] = run + i * count;
+		for (j = 0; j < count; j++) element_init(batch->secret_commitments[i][j], proof->G_type->field);
+	}
+	for (i = 0; i < num_public; i++) {
+		batch->public_values[i] = run + (num_secret + i) * count;
+		for (j = 0; j < count; j++) element_init(batch->public_values[i][j], proof->Z_type->field);
+	}
+	batch->challenges = run + (num_secret + num_public) * count;
+	for (j = 0; j < count; j++) element_init(batch->challenges[j], proof->Z_type->field);
+	batch->scratch_Z = batch->challenges + count;
+	batch->scratch_G = batch->scratch_Z + INST_SCRATCH;
+	for (j = 0; j < INST_SCRATCH; j++) {
+		element_init(batch->scratch_Z[j], proof->Z_type->field);
+		element_init(batch->scratch_G[j], proof->G_type->field);
+	}
+	
+	// The view shares the scratch space of the batch, and its values are shallow copies
+	// of the elements of one instance.
+	batch->view.secret_values = NULL;
+	batch->view.secret_openings = NULL;
+	batch->view.secret_commitments = (element_t*)pbc_malloc(sizeof(element_t) * (num_secret + num_public + 1));
+	batch->view.public_values = batch->view.secret_commitments + num_secret;
+	batch->view.supplement_data = new((type_ptr)&proof->supplement_type);
+	batch->view.scratch_Z = batch->scratch_Z;
+	batch->view.scratch_G = batch->scratch_G;
+	batch->view.dirty = NULL;
+}
+
+void batch_clear(batch_t batch) {
+	long i;
+	proof_ptr proof = batch->proof;
+	long before = (proof->num_secret + proof->num_public) * batch->count;
+	long total = before + batch->count + 2 * INST_SCRATCH;
+	element_t *run = batch->challenges - before;
+	for (i = 0; i < total; i++) element_clear(run[i]);
+	pbc_free(run);
+	pbc_free(batch->secret_commitments);
+	pbc_free(batch->view.secret_commitments);
+	delete((type_ptr)&proof->supplement_type, batch->view.supplement_data);
+}
+
+void batch_set_inst(batch_t batch, int index, inst_t inst) {
+	long i;
+	for (i = 0; i < batch->proof->num_secret; i++) {
+		element_set(batch->secret_commitments[i][index], inst->secret_commitments[i]);
+	}
+	for (i = 0; i < batch->proof->num_public; i++) {
+		element_set(batch->public_values[i][index], inst->public_values[i]);
+	}
+}
+
+element_ptr batch_commitment(batch_t batch, int index, var_t var) {
+	assert(var_is_secret(var));
+	return batch->secret_commitments[var_index(var)][index];
+}
+
+element_ptr batch_public(batch_t batch, int index, var_t var) {
+	assert(var_is_public(var));
+	return batch->public_values[var_index(var)][index];
+}
+
+element_ptr batch_challenge(batch_t batch, int index) {
+	return batch->challenges[index];
+}
+
+// Points the view of a batch at the values of one instance.
+void _batch_view(batch_t batch, int index) {
+	long i;
+	for (i = 0; i < batch->proof->num_secret; i++) {
+		*batch->view.secret_commitments[i] = *batch->secret_commitments[i][index];
+	}
+	for (i = 0; i < batch->proof->num_public; i++) {
+		*batch->view.public_values[i] = *batch->public_values[i][index];
+	}
+}
+
+int batch_verify(batch_t batch, data_ptr* claim_public, data_ptr* response, int* valid) {
+	int i, j; int count = batch->count; int result = 0;
+	proof_ptr proof = batch->proof;
+	data_ptr *block_claim_public = (data_ptr*)pbc_malloc(sizeof(data_ptr) * 2 * (count > 0 ? count : 1));
+	data_ptr *block_response = block_claim_public + count;
+	for (j = 0; j < count; j++) valid[j] = 1;
+	for (i = 0; i < proof->num_blocks; i++) {
+		plan_entry_ptr entry = &proof->plan[proof->plan_order[i]];
+		block_ptr block = entry->block;
+		for (j = 0; j < count; j++) {
+			block_claim_public[j] = get_block_part(entry, PART_CLAIM_PUBLIC, claim_public[j]);
+			block_response[j] = get_block_part(entry, PART_RESPONSE, response[j]);
+		}
+		if (block->response_verify_batch != NULL) {
+			block->response_verify_batch(block, proof, batch, block_claim_public, block_response, valid);
+		} else {
+			for (j = 0; j < count; j++) {
+				if (!valid[j]) continue;
+				_batch_view(batch, j);
+				valid[j] = block->response_verify(block, proof, &batch->view,
+					block_claim_public[j], batch->challenges[j], block_response[j]);
+			}
+		}
+	}
+	pbc_free(block_claim_public);
+	for (j = 0; j < count; j++) result += valid[j] != 0;
+	return result;
+}
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <time.h>
+#include "zkp.h"
+#include "zkp_internal.h"
+
+// Times mpz_decompose on random values of several sizes, and checks every result.
+
+double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Checks that n = a ^ 2 + b ^ 2 + c ^ 2 + d ^ 2.
+int check(mpz_t n, mpz_t a, mpz_t b, mpz_t c, mpz_t d) {
+	int valid;
+	mpz_t sum; mpz_init(sum);
+	mpz_mul(sum, a, a);
+	mpz_addmul(sum, b, b);
+	mpz_addmul(sum, c, c);
+	mpz_addmul(sum, d, d);
+	valid = !mpz_cmp(sum, n);
+	mpz_clear(sum);
+	return valid;
+}
+
+int main() {
+	int sizes[] = { 64, 128, 256, 512, 1024, 2048 };
+	int i, j;
+	gmp_randstate_t state;
+	gmp_randinit_default(state);
+	gmp_randseed_ui(state, 42);
+	mpz_t n, a, b, c, d;
+	mpz_inits(n, a, b, c, d, NULL);
+
+	// Small values cover the special cases of the search.
+	for (i = 0; i < 100000; i++) {
+		mpz_set_ui(n, i);
+		mpz_decompose(a, b, c, d, n);
+		if (!check(n, a, b, c, d)) pbc_die("wrong decomposition of %d", i);
+	}
+
+	for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+		int reps = sizes[i] >= 1024 ? 100 : 1000;
+		double total = 0;
+		for (j = 0; j < reps; j++) {
+			mpz_urandomb(n, state, sizes[i]);
+			double start = now();
+			mpz_decompose(a, b, c, d, n);
+			total += now() - start;
+			if (!check(n, a, b, c, d)) pbc_die("wrong decomposition");
+		}
+		printf("%5d bits: %9.1f us\n", sizes[i], total / reps * 1e6);
+	}
+
+	mpz_clears(n, a, b, c, d, NULL);
+	gmp_randclear(state);
+	return 0;
+}
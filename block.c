@@ -1,11 +1,15 @@
 #include <assert.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <pbc.h>
 #include "zkp_io.h"
 #include "zkp_proof.h"
 #include "zkp_internal.h"
+#include "zkp_batch.h"
 
 void block_insert(proof_t proof, block_ptr block) {
+	assert(proof->plan == NULL);
 	block->next = proof->first_block;
 	proof->first_block = block;
 	proof->supplement_type.base->size += block->supplement_type->size;
@@ -17,12 +21,103 @@ void block_insert(proof_t proof, block_ptr block) {
 void blocks_clear(proof_t proof) {
 	block_ptr current = proof->first_block;
 	while (current != NULL) {
+		block_ptr next = current->next;
 		current->clear(current);
-		current = current->next;
+		current = next;
+	}
+	if (proof->plan != NULL) {
+		pbc_free(proof->plan);
+		pbc_free(proof->plan_order);
+	}
+}
+
+void proof_finalize(proof_t proof) {
+	int i; int count = 0; int max_kind = 0;
+	block_ptr current;
+	assert(proof->plan == NULL);
+	for (current = proof->first_block; current != NULL; current = current->next) {
+		if (current->kind > max_kind) max_kind = current->kind;
+		count++;
+	}
+	computations_finalize(proof);
+	proof->num_blocks = count;
+	proof->plan = (plan_entry_ptr)pbc_malloc(sizeof(plan_entry_t) * (count > 0 ? count : 1));
+	proof->plan_order = (int*)pbc_malloc(sizeof(int) * (count > 0 ? count : 1));
+	
+	// Lay out entries in list order, accumulating offsets.
+	size_t offsets[PART_COUNT] = { 0, 0, 0, 0 };
+	for (i = 0, current = proof->first_block; current != NULL; i++, current = current->next) {
+		int part;
+		plan_entry_ptr entry = &proof->plan[i];
+		entry->block = current;
+		entry->kind = current->kind;
+		entry->types[PART_SUPPLEMENT] = current->supplement_type;
+		entry->types[PART_CLAIM_SECRET] = current->claim_secret_type;
+		entry->types[PART_CLAIM_PUBLIC] = current->claim_public_type;
+		entry->types[PART_RESPONSE] = current->response_type;
+		for (part = 0; part < PART_COUNT; part++) {
+			entry->offsets[part] = offsets[part];
+			offsets[part] += entry->types[part]->size;
+		}
+	}
+	
+	// Order execution by kind, keeping list order within each kind.
+	int *starts = (int*)pbc_malloc(sizeof(int) * (max_kind + 2));
+	for (i = 0; i < max_kind + 2; i++) starts[i] = 0;
+	for (i = 0; i < count; i++) starts[proof->plan[i].kind + 1]++;
+	for (i = 0; i < max_kind + 1; i++) starts[i + 1] += starts[i];
+	for (i = 0; i < count; i++) proof->plan_order[starts[proof->plan[i].kind]++] = i;
+	pbc_free(starts);
+}
+
+int _equals_public_read(proof_t, FILE*);
+int _equals_read(proof_t, FILE*);
+int _wsum_zero_read(proof_t, FILE*);
+int _product_read(proof_t, FILE*);
+int _inner_product_read(proof_t, FILE*);
+int _products_read(proof_t, FILE*);
+int _linear_system_read(proof_t, FILE*);
+int block_read(proof_t proof, int kind, proof_refs_t refs, FILE* stream) {
+	switch (kind) {
+		case BLOCK_EQUALS_PUBLIC: return _equals_public_read(proof, stream);
+		case BLOCK_EQUALS: return _equals_read(proof, stream);
+		case BLOCK_WSUM_ZERO: return _wsum_zero_read(proof, stream);
+		case BLOCK_PRODUCT: return _product_read(proof, stream);
+		case BLOCK_SIG: return block_sig_read(proof, refs, stream);
+		case BLOCK_ACCUMULATED: return block_accumulated_read(proof, refs, stream);
+		case BLOCK_INNER_PRODUCT: return _inner_product_read(proof, stream);
+		case BLOCK_PRODUCTS: return _products_read(proof, stream);
+		case BLOCK_IPA: return block_ipa_read(proof, stream);
+		case BLOCK_VECTOR_INNER_PRODUCT: return block_vector_inner_product_read(proof, stream);
+		case BLOCK_VECTOR_LINEAR: return block_vector_linear_read(proof, stream);
+		case BLOCK_LINEAR_SYSTEM: return _linear_system_read(proof, stream);
 	}
+	return 0;
+}
+
+int index_read(long* index, long count, FILE* stream) {
+	uint64_t value;
+	if (u64_read(&value, stream) != 8 || value >= (uint64_t)count) return 0;
+	*index = (long)value;
+	return 1;
+}
+
+int secret_index_read(proof_t proof, long* index, FILE* stream) {
+	if (!index_read(index, proof->num_secret, stream)) return 0;
+	return secret_vector_find(proof, *index) < 0;
 }
 
 void claim_gen(proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
+	if (proof->plan != NULL) {
+		int i;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[proof->plan_order[i]];
+			entry->block->claim_gen(entry->block, proof, inst,
+				get_block_part(entry, PART_CLAIM_SECRET, claim_secret),
+				get_block_part(entry, PART_CLAIM_PUBLIC, claim_public));
+		}
+		return;
+	}
 	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		current->claim_gen(current, proof, inst, claim_secret, claim_public);
@@ -33,6 +128,16 @@ void claim_gen(proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim
 }
 
 void response_gen(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
+	if (proof->plan != NULL) {
+		int i;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[proof->plan_order[i]];
+			entry->block->response_gen(entry->block, proof, inst,
+				get_block_part(entry, PART_CLAIM_SECRET, claim_secret), challenge,
+				get_block_part(entry, PART_RESPONSE, response));
+		}
+		return;
+	}
 	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		current->response_gen(current, proof, inst, claim_secret, challenge, response);
@@ -43,6 +148,16 @@ void response_gen(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t
 }
 
 int response_verify(proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	if (proof->plan != NULL) {
+		int i;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[proof->plan_order[i]];
+			if (!entry->block->response_verify(entry->block, proof, inst,
+				get_block_part(entry, PART_CLAIM_PUBLIC, claim_public), challenge,
+				get_block_part(entry, PART_RESPONSE, response))) return 0;
+		}
+		return 1;
+	}
 	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		if (!current->response_verify(current, proof, inst, claim_public, challenge, response)) return 0;
@@ -55,7 +170,16 @@ int response_verify(proof_t proof, inst_t inst, data_ptr claim_public, challenge
 
 void _multi_init(type_ptr type, data_ptr data) {
 	struct multi_type_s *self = (struct multi_type_s*)type;
-	block_ptr current = self->proof->first_block;
+	proof_ptr proof = self->proof;
+	if (proof->plan != NULL) {
+		int i; int part = self->part;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[i];
+			init(entry->types[part], get_block_part(entry, part, data));
+		}
+		return;
+	}
+	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		type_ptr block_type = self->for_block(current);
 		init(block_type, data);
@@ -66,7 +190,16 @@ void _multi_init(type_ptr type, data_ptr data) {
 
 void _multi_clear(type_ptr type, data_ptr data) {
 	struct multi_type_s *self = (struct multi_type_s*)type;
-	block_ptr current = self->proof->first_block;
+	proof_ptr proof = self->proof;
+	if (proof->plan != NULL) {
+		int i; int part = self->part;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[i];
+			clear(entry->types[part], get_block_part(entry, part, data));
+		}
+		return;
+	}
+	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		type_ptr block_type = self->for_block(current);
 		clear(block_type, data);
@@ -77,7 +210,16 @@ void _multi_clear(type_ptr type, data_ptr data) {
 
 void _multi_write(type_ptr type, data_ptr data, FILE* stream) {
 	struct multi_type_s *self = (struct multi_type_s*)type;
-	block_ptr current = self->proof->first_block;
+	proof_ptr proof = self->proof;
+	if (proof->plan != NULL) {
+		int i; int part = self->part;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[i];
+			write(entry->types[part], get_block_part(entry, part, data), stream);
+		}
+		return;
+	}
+	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		type_ptr block_type = self->for_block(current);
 		write(block_type, data, stream);
@@ -88,7 +230,16 @@ void _multi_write(type_ptr type, data_ptr data, FILE* stream) {
 
 void _multi_read(type_ptr type, data_ptr data, FILE* stream) {
 	struct multi_type_s *self = (struct multi_type_s*)type;
-	block_ptr current = self->proof->first_block;
+	proof_ptr proof = self->proof;
+	if (proof->plan != NULL) {
+		int i; int part = self->part;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[i];
+			read(entry->types[part], get_block_part(entry, part, data), stream);
+		}
+		return;
+	}
+	block_ptr current = proof->first_block;
 	while (current != NULL) {
 		type_ptr block_type = self->for_block(current);
 		read(block_type, data, stream);
@@ -97,6 +248,32 @@ void _multi_read(type_ptr type, data_ptr data, FILE* stream) {
 	}
 }
 
+size_t _multi_read_bytes(type_ptr type, data_ptr data, const unsigned char* bytes, size_t size) {
+	struct multi_type_s *self = (struct multi_type_s*)type;
+	proof_ptr proof = self->proof;
+	size_t len = 0;
+	if (proof->plan != NULL) {
+		int i; int part = self->part;
+		for (i = 0; i < proof->num_blocks; i++) {
+			plan_entry_ptr entry = &proof->plan[i];
+			size_t block_len = read_bytes(entry->types[part], get_block_part(entry, part, data), bytes + len, size - len);
+			if (read_failed(block_len)) return block_len;
+			len += block_len;
+		}
+		return len;
+	}
+	block_ptr current = proof->first_block;
+	while (current != NULL) {
+		type_ptr block_type = self->for_block(current);
+		size_t block_len = read_bytes(block_type, data, bytes + len, size - len);
+		if (read_failed(block_len)) return block_len;
+		len += block_len;
+		data = (data_ptr)((char*)data + block_type->size);
+		current = current->next;
+	}
+	return len;
+}
+
 type_ptr _supplement_type_for_block(block_ptr block) {
 	return block->supplement_type;
 }
@@ -137,19 +314,28 @@ typedef struct block_equals_public_s {
 // [e * o_s + r] * g ^ (e * p)	= (C_s) ^ e * R
 
 void _equals_public_clear(block_ptr);
+int _equals_public_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _equals_public_codegen(block_ptr, proof_t, codegen_ptr);
 void _equals_public_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
 void _equals_public_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
 int _equals_public_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+void _equals_public_response_verify_batch(block_ptr, proof_t, batch_ptr, data_ptr*, data_ptr*, int*);
 void block_equals_public(proof_t proof, long secret_index, long public_index) {
 	block_equals_public_ptr self = (block_equals_public_ptr)pbc_malloc(sizeof(block_equals_public_t));
 	self->base->clear = &_equals_public_clear;
+	self->base->write = &_equals_public_write;
+	self->base->codegen = &_equals_public_codegen;
 	self->base->claim_gen = &_equals_public_claim_gen;
 	self->base->response_gen = &_equals_public_response_gen;
 	self->base->response_verify = &_equals_public_response_verify;
+	self->base->response_verify_batch = &_equals_public_response_verify_batch;
+	self->base->response_verify_step = NULL;
+	self->base->verify_steps = 1;
 	self->base->supplement_type = (type_ptr)void_type;
 	self->base->claim_secret_type = (type_ptr)proof->Z_type;
 	self->base->claim_public_type = (type_ptr)proof->G_type;
 	self->base->response_type = (type_ptr)proof->Z_type;
+	self->base->kind = BLOCK_EQUALS_PUBLIC;
 	self->secret_index = secret_index;
 	self->public_index = public_index;
 	block_insert(proof, (block_ptr)self);
@@ -159,13 +345,54 @@ void _equals_public_clear(block_ptr block) {
 	pbc_free((block_equals_public_ptr)block);
 }
 
+int _equals_public_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_equals_public_ptr self = (block_equals_public_ptr)block;
+	u64_write(self->secret_index, stream);
+	u64_write(self->public_index, stream);
+	return 1;
+}
+
+int _equals_public_read(proof_t proof, FILE* stream) {
+	long secret_index, public_index;
+	if (!secret_index_read(proof, &secret_index, stream)) return 0;
+	if (!index_read(&public_index, proof->num_public, stream)) return 0;
+	block_equals_public(proof, secret_index, public_index);
+	return 1;
+}
+
+void _equals_public_codegen(block_ptr block, proof_t proof, codegen_ptr gen) {
+	block_equals_public_ptr self = (block_equals_public_ptr)block;
+	FILE* out = gen->stream;
+	size_t cs = gen->base[PART_CLAIM_SECRET];
+	size_t cp = gen->base[PART_CLAIM_PUBLIC];
+	size_t rs = gen->base[PART_RESPONSE];
+	if (gen->stage != CODEGEN_BODY) return;
+	switch (gen->routine) {
+		case CODEGEN_CLAIM_GEN:
+			fprintf(out, "\telement_random(CS(%zu));\n", cs);
+			fprintf(out, "\tproof_pow_h(proof, CP(%zu), CS(%zu));\n", cp, cs);
+			break;
+		case CODEGEN_RESPONSE_GEN:
+			fprintf(out, "\telement_mul(RS(%zu), challenge, SO(%ld));\n", rs, self->secret_index);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs, rs, cs);
+			break;
+		case CODEGEN_RESPONSE_VERIFY:
+			fprintf(out, "\telement_mul(Z0, challenge, PV(%ld));\n", self->public_index);
+			fprintf(out, "\tproof_pow_gh(proof, G0, Z0, RS(%zu));\n", rs);
+			fprintf(out, "\telement_pow_zn(G1, SC(%ld), challenge);\n", self->secret_index);
+			fprintf(out, "\telement_mul(G1, G1, CP(%zu));\n", cp);
+			fprintf(out, "\tif (element_cmp(G0, G1)) goto invalid;\n");
+			break;
+	}
+}
+
 void _equals_public_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
 	element_ptr r = get_element((element_type_ptr)proof->Z_type, claim_secret);
 	element_ptr R = get_element((element_type_ptr)proof->G_type, claim_public);
 	
 	// R = h ^ o_r
 	element_random(r);
-	element_pow_zn(R, proof->h, r);
+	proof_pow_h(proof, R, r);
 }
 
 void _equals_public_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
@@ -184,18 +411,36 @@ int _equals_public_response_verify(block_ptr block, proof_t proof, inst_t inst,
 	element_ptr x = get_element((element_type_ptr)proof->Z_type, response);
 	
 	// Verify [x] * g ^ (e * p) = (C_s) ^ e * R
-	element_t gexp; element_init(gexp, proof->Z_type->field);
+	element_ptr gexp = inst->scratch_Z[0];
+	element_ptr left = inst->scratch_G[0];
+	element_ptr right = inst->scratch_G[1];
 	element_mul(gexp, challenge, inst->public_values[self->public_index]);
-	element_t left; element_init(left, proof->G_type->field);
-	element_pow2_zn(left, proof->g, gexp, proof->h, x);
-	element_t right; element_init(right, proof->G_type->field);
+	proof_pow_gh(proof, left, gexp, x);
 	element_pow_zn(right, inst->secret_commitments[self->secret_index], challenge);
 	element_mul(right, right, R);
-	int result = !element_cmp(left, right);
-	element_clear(gexp);
-	element_clear(left);
-	element_clear(right);
-	return result;
+	return !element_cmp(left, right);
+}
+
+void _equals_public_response_verify_batch(block_ptr block, proof_t proof, batch_ptr batch, data_ptr* claim_public, data_ptr* response, int* valid) {
+	block_equals_public_ptr self = (block_equals_public_ptr)block;
+	int i; int count = batch->count;
+	element_t *C_s = batch->secret_commitments[self->secret_index];
+	element_t *p = batch->public_values[self->public_index];
+	element_ptr gexp = batch->scratch_Z[0];
+	element_ptr left = batch->scratch_G[0];
+	element_ptr right = batch->scratch_G[1];
+	for (i = 0; i < count; i++) {
+		if (!valid[i]) continue;
+		element_ptr R = get_element((element_type_ptr)proof->G_type, claim_public[i]);
+		element_ptr x = get_element((element_type_ptr)proof->Z_type, response[i]);
+		
+		// Verify [x] * g ^ (e * p) = (C_s) ^ e * R
+		element_mul(gexp, batch->challenges[i], p[i]);
+		proof_pow_gh(proof, left, gexp, x);
+		element_pow_zn(right, C_s[i], batch->challenges[i]);
+		element_mul(right, right, R);
+		valid[i] = !element_cmp(left, right);
+	}
 }
 
 /***************************************************
@@ -224,21 +469,30 @@ typedef struct block_equals_s {
 // [e(s_1, o_s_1, o_s_2, ...) + r]	= (C_s_1 ^ e * R, C_s_2 ^ e * R, ...)
 
 void _equals_clear(block_ptr);
+int _equals_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _equals_codegen(block_ptr, proof_t, codegen_ptr);
 void _equals_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
 void _equals_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
 int _equals_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+void _equals_response_verify_batch(block_ptr, proof_t, batch_ptr, data_ptr*, data_ptr*, int*);
 block_equals_ptr block_equals_base(proof_t proof, int count) {
 	block_equals_ptr self = (block_equals_ptr)pbc_malloc(sizeof(block_equals_t));
 	array_type_init(self->Zx_type, (type_ptr)proof->Z_type, 1 + count);
 	array_type_init(self->Gx_type, (type_ptr)proof->G_type, count);
 	self->base->clear = &_equals_clear;
+	self->base->write = &_equals_write;
+	self->base->codegen = &_equals_codegen;
 	self->base->claim_gen = &_equals_claim_gen;
 	self->base->response_gen = &_equals_response_gen;
 	self->base->response_verify = &_equals_response_verify;
+	self->base->response_verify_batch = &_equals_response_verify_batch;
+	self->base->response_verify_step = NULL;
+	self->base->verify_steps = 1;
 	self->base->supplement_type = (type_ptr)void_type;
 	self->base->claim_secret_type = (type_ptr)self->Zx_type;
 	self->base->claim_public_type = (type_ptr)self->Gx_type;
 	self->base->response_type = (type_ptr)self->Zx_type;
+	self->base->kind = BLOCK_EQUALS;
 	self->indices = (long*)pbc_malloc(sizeof(long) * count);
 	self->count = count;
 	block_insert(proof, (block_ptr)self);
@@ -257,6 +511,59 @@ void _equals_clear(block_ptr block) {
 	pbc_free(self);
 }
 
+int _equals_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_equals_ptr self = (block_equals_ptr)block;
+	int i; int count = self->count;
+	u64_write(count, stream);
+	for (i = 0; i < count; i++) u64_write(self->indices[i], stream);
+	return 1;
+}
+
+int _equals_read(proof_t proof, FILE* stream) {
+	int i; uint64_t count;
+	if (u64_read(&count, stream) != 8 || count == 0 || count > INT_MAX) return 0;
+	block_equals_ptr self = block_equals_base(proof, (int)count);
+	for (i = 0; i < (int)count; i++) {
+		if (!secret_index_read(proof, &self->indices[i], stream)) return 0;
+	}
+	return 1;
+}
+
+void _equals_codegen(block_ptr block, proof_t proof, codegen_ptr gen) {
+	block_equals_ptr self = (block_equals_ptr)block;
+	FILE* out = gen->stream;
+	int i; int count = self->count;
+	size_t cs = gen->base[PART_CLAIM_SECRET];
+	size_t cp = gen->base[PART_CLAIM_PUBLIC];
+	size_t rs = gen->base[PART_RESPONSE];
+	if (gen->stage != CODEGEN_BODY) return;
+	switch (gen->routine) {
+		case CODEGEN_CLAIM_GEN:
+			fprintf(out, "\telement_random(CS(%zu));\n", cs);
+			for (i = 0; i < count; i++) {
+				fprintf(out, "\telement_random(CS(%zu));\n", cs + 1 + i);
+				fprintf(out, "\tproof_pow_gh(proof, CP(%zu), CS(%zu), CS(%zu));\n", cp + i, cs, cs + 1 + i);
+			}
+			break;
+		case CODEGEN_RESPONSE_GEN:
+			fprintf(out, "\telement_mul(RS(%zu), challenge, SV(%ld));\n", rs, self->indices[0]);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs, rs, cs);
+			for (i = 0; i < count; i++) {
+				fprintf(out, "\telement_mul(RS(%zu), challenge, SO(%ld));\n", rs + 1 + i, self->indices[i]);
+				fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs + 1 + i, rs + 1 + i, cs + 1 + i);
+			}
+			break;
+		case CODEGEN_RESPONSE_VERIFY:
+			for (i = 0; i < count; i++) {
+				fprintf(out, "\tproof_pow_gh(proof, G0, RS(%zu), RS(%zu));\n", rs, rs + 1 + i);
+				fprintf(out, "\telement_pow_zn(G1, SC(%ld), challenge);\n", self->indices[i]);
+				fprintf(out, "\telement_mul(G1, G1, CP(%zu));\n", cp + i);
+				fprintf(out, "\tif (element_cmp(G0, G1)) goto invalid;\n");
+			}
+			break;
+	}
+}
+
 void _equals_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
 	block_equals_ptr self = (block_equals_ptr)block;
 	int i; int count = self->count;
@@ -268,7 +575,7 @@ void _equals_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr cla
 		
 		// R_# = g ^ r * h ^ o_r_#
 		element_random(o_r);
-		element_pow2_zn(R, proof->g, r, proof->h, o_r);
+		proof_pow_gh(proof, R, r, o_r);
 	}
 }
 
@@ -298,26 +605,41 @@ int _equals_response_verify(block_ptr block, proof_t proof, inst_t inst, data_pt
 	element_ptr x = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response, 0));
 	
 	// Verify [x] = (C_s_1 ^ e * R, C_s_2 ^ e * R, ...)
-	int result = 1;
-	element_t left; element_init(left, proof->G_type->field);
-	element_t right; element_init(right, proof->G_type->field);
+	element_ptr left = inst->scratch_G[0];
+	element_ptr right = inst->scratch_G[1];
 	for (i = 0; i < count; i++) {
 		element_ptr R = get_element((element_type_ptr)proof->G_type, get_item((array_type_ptr)self->Gx_type, claim_public, i));
 		element_ptr o_x = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response, i + 1));
 		
 		// Verify g ^ x * h ^ o_x_# = C_s_# ^ e * R_#
-		element_pow2_zn(left, proof->g, x, proof->h, o_x);
+		proof_pow_gh(proof, left, x, o_x);
 		element_pow_zn(right, inst->secret_commitments[self->indices[i]], challenge);
 		element_mul(right, right, R);
-		if (element_cmp(left, right)) {
-			result = 0;
-			break;
-		}
+		if (element_cmp(left, right)) return 0;
 	}
+	return 1;
+}
 
-	element_clear(left);
-	element_clear(right);
-	return result;
+void _equals_response_verify_batch(block_ptr block, proof_t proof, batch_ptr batch, data_ptr* claim_public, data_ptr* response, int* valid) {
+	block_equals_ptr self = (block_equals_ptr)block;
+	int i, j; int count = self->count;
+	element_ptr left = batch->scratch_G[0];
+	element_ptr right = batch->scratch_G[1];
+	for (j = 0; j < count; j++) {
+		element_t *C_s = batch->secret_commitments[self->indices[j]];
+		for (i = 0; i < batch->count; i++) {
+			if (!valid[i]) continue;
+			element_ptr x = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response[i], 0));
+			element_ptr o_x = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response[i], j + 1));
+			element_ptr R = get_element((element_type_ptr)proof->G_type, get_item((array_type_ptr)self->Gx_type, claim_public[i], j));
+			
+			// Verify g ^ x * h ^ o_x_# = C_s_# ^ e * R_#
+			proof_pow_gh(proof, left, x, o_x);
+			element_pow_zn(right, C_s[i], batch->challenges[i]);
+			element_mul(right, right, R);
+			valid[i] = !element_cmp(left, right);
+		}
+	}
 }
 
 void require_equal(proof_t proof, int count, /* var_t a, var_t b, */ ...) {
@@ -360,19 +682,28 @@ typedef struct block_wsum_zero_s {
 // [r - e(o_s_1 * k_1 + o_s_2 * k_2 + ...)] * (C_s_1) ^ ek_1 * (C_s_2) ^ ek_2 * ...	= R
 
 void _wsum_zero_clear(block_ptr);
+int _wsum_zero_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _wsum_zero_codegen(block_ptr, proof_t, codegen_ptr);
 void _wsum_zero_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
 void _wsum_zero_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
 int _wsum_zero_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+void _wsum_zero_response_verify_batch(block_ptr, proof_t, batch_ptr, data_ptr*, data_ptr*, int*);
 block_wsum_zero_ptr block_wsum_zero_base(proof_t proof, int count) {
 	block_wsum_zero_ptr self = (block_wsum_zero_ptr)pbc_malloc(sizeof(block_wsum_zero_t));
 	self->base->clear = &_wsum_zero_clear;
+	self->base->write = &_wsum_zero_write;
+	self->base->codegen = &_wsum_zero_codegen;
 	self->base->claim_gen = &_wsum_zero_claim_gen;
 	self->base->response_gen = &_wsum_zero_response_gen;
 	self->base->response_verify = &_wsum_zero_response_verify;
+	self->base->response_verify_batch = &_wsum_zero_response_verify_batch;
+	self->base->response_verify_step = NULL;
+	self->base->verify_steps = 1;
 	self->base->supplement_type = (type_ptr)void_type;
 	self->base->claim_secret_type = (type_ptr)proof->Z_type;
 	self->base->claim_public_type = (type_ptr)proof->G_type;
 	self->base->response_type = (type_ptr)proof->Z_type;
+	self->base->kind = BLOCK_WSUM_ZERO;
 	self->indices = (long*)pbc_malloc(sizeof(long) * count);
 	self->coefficients = (long*)pbc_malloc(sizeof(long) * count);
 	self->count = count;
@@ -387,13 +718,70 @@ void _wsum_zero_clear(block_ptr block) {
 	pbc_free(self);
 }
 
+int _wsum_zero_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_wsum_zero_ptr self = (block_wsum_zero_ptr)block;
+	int i; int count = self->count;
+	u64_write(count, stream);
+	for (i = 0; i < count; i++) {
+		u64_write((uint64_t)self->coefficients[i], stream);
+		u64_write(self->indices[i], stream);
+	}
+	return 1;
+}
+
+int _wsum_zero_read(proof_t proof, FILE* stream) {
+	int i; uint64_t count, coefficient;
+	if (u64_read(&count, stream) != 8 || count == 0 || count > INT_MAX) return 0;
+	block_wsum_zero_ptr self = block_wsum_zero_base(proof, (int)count);
+	for (i = 0; i < (int)count; i++) {
+		if (u64_read(&coefficient, stream) != 8) return 0;
+		self->coefficients[i] = (long)(int64_t)coefficient;
+		if (!secret_index_read(proof, &self->indices[i], stream)) return 0;
+	}
+	return 1;
+}
+
+void _wsum_zero_codegen(block_ptr block, proof_t proof, codegen_ptr gen) {
+	block_wsum_zero_ptr self = (block_wsum_zero_ptr)block;
+	FILE* out = gen->stream;
+	int i; int count = self->count;
+	size_t cs = gen->base[PART_CLAIM_SECRET];
+	size_t cp = gen->base[PART_CLAIM_PUBLIC];
+	size_t rs = gen->base[PART_RESPONSE];
+	if (gen->stage != CODEGEN_BODY) return;
+	switch (gen->routine) {
+		case CODEGEN_CLAIM_GEN:
+			fprintf(out, "\telement_random(CS(%zu));\n", cs);
+			fprintf(out, "\tproof_pow_h(proof, CP(%zu), CS(%zu));\n", cp, cs);
+			break;
+		case CODEGEN_RESPONSE_GEN:
+			fprintf(out, "\telement_set0(RS(%zu));\n", rs);
+			for (i = 0; i < count; i++) {
+				fprintf(out, "\telement_mul_si(Z0, SO(%ld), %ld);\n", self->indices[i], self->coefficients[i]);
+				fprintf(out, "\telement_add(RS(%zu), RS(%zu), Z0);\n", rs, rs);
+			}
+			fprintf(out, "\telement_mul(RS(%zu), RS(%zu), challenge);\n", rs, rs);
+			fprintf(out, "\telement_sub(RS(%zu), CS(%zu), RS(%zu));\n", rs, cs, rs);
+			break;
+		case CODEGEN_RESPONSE_VERIFY:
+			fprintf(out, "\telement_set1(G0);\n");
+			for (i = 0; i < count; i++) {
+				fprintf(out, "\telement_mul_si(G1, SC(%ld), %ld);\n", self->indices[i], self->coefficients[i]);
+				fprintf(out, "\telement_mul(G0, G0, G1);\n");
+			}
+			fprintf(out, "\telement_pow2_zn(G0, proof->h, RS(%zu), G0, challenge);\n", rs);
+			fprintf(out, "\tif (element_cmp(G0, CP(%zu))) goto invalid;\n", cp);
+			break;
+	}
+}
+
 void _wsum_zero_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
 	element_ptr r = get_element((element_type_ptr)proof->Z_type, claim_secret);
 	element_ptr R = get_element((element_type_ptr)proof->G_type, claim_public);
 	
 	// R = h ^ o_r
 	element_random(r);
-	element_pow_zn(R, proof->h, r);
+	proof_pow_h(proof, R, r);
 }
 
 void _wsum_zero_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
@@ -403,7 +791,7 @@ void _wsum_zero_response_gen(block_ptr block, proof_t proof, inst_t inst, data_p
 	element_ptr x = get_element((element_type_ptr)proof->Z_type, response);
 	
 	// x = r - e(o_s_1 * k_1 + o_s_2 * k_2 + ...)
-	element_t term; element_init(term, proof->Z_type->field);
+	element_ptr term = inst->scratch_Z[0];
 	element_set0(x);
 	for (i = 0; i < count; i++) {
 		element_mul_si(term, inst->secret_openings[self->indices[i]], self->coefficients[i]);
@@ -411,7 +799,6 @@ void _wsum_zero_response_gen(block_ptr block, proof_t proof, inst_t inst, data_p
 	}
 	element_mul(x, x, challenge);
 	element_sub(x, r, x);
-	element_clear(term);
 }
 
 int _wsum_zero_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
@@ -421,17 +808,36 @@ int _wsum_zero_response_verify(block_ptr block, proof_t proof, inst_t inst, data
 	element_ptr x = get_element((element_type_ptr)proof->Z_type, response);
 	
 	// Verify [x] * (C_s_1) ^ (e * k_1) * (C_s_2) ^ (e * k_2) * ... = R
-	element_t left; element_init(left, proof->G_type->field);
-	element_t term; element_init(term, proof->G_type->field);
+	element_ptr left = inst->scratch_G[0];
+	element_ptr term = inst->scratch_G[1];
+	element_set1(left);
 	for (i = 0; i < count; i++) {
 		element_mul_si(term, inst->secret_commitments[self->indices[i]], self->coefficients[i]);
 		element_mul(left, left, term);
 	}
 	element_pow2_zn(left, proof->h, x, left, challenge);
-	int result = !element_cmp(left, R);
-	element_clear(left);
-	element_clear(term);
-	return result;
+	return !element_cmp(left, R);
+}
+
+void _wsum_zero_response_verify_batch(block_ptr block, proof_t proof, batch_ptr batch, data_ptr* claim_public, data_ptr* response, int* valid) {
+	block_wsum_zero_ptr self = (block_wsum_zero_ptr)block;
+	int i, j; int count = self->count;
+	element_ptr left = batch->scratch_G[0];
+	element_ptr term = batch->scratch_G[1];
+	for (i = 0; i < batch->count; i++) {
+		if (!valid[i]) continue;
+		element_ptr R = get_element((element_type_ptr)proof->G_type, claim_public[i]);
+		element_ptr x = get_element((element_type_ptr)proof->Z_type, response[i]);
+		
+		// Verify [x] * (C_s_1) ^ (e * k_1) * (C_s_2) ^ (e * k_2) * ... = R
+		element_set1(left);
+		for (j = 0; j < count; j++) {
+			element_mul_si(term, batch->secret_commitments[self->indices[j]][i], self->coefficients[j]);
+			element_mul(left, left, term);
+		}
+		element_pow2_zn(left, proof->h, x, left, batch->challenges[i]);
+		valid[i] = !element_cmp(left, R);
+	}
 }
 
 void require_sum(proof_t proof, var_t sum, var_t addend_1, var_t addend_2) {
@@ -469,6 +875,245 @@ void require_wsum_zero_many(proof_t proof, int count, long* coeffs, var_t* vars)
 	}
 }
 
+/***************************************************
+* linear_system
+*
+* Verifies that a set of secret variables satisfies
+* a system of linear equations with field coefficients
+* and public right-hand sides, checking every equation
+* at once.
+****************************************************/
+
+typedef struct block_linear_system_s *block_linear_system_ptr;
+typedef struct block_linear_system_s {
+	block_t base;
+	int rows;
+	int num_columns;
+	int num_entries;
+	long *columns;
+	long *rhs_indices;
+	int *row_starts;
+	int *entry_columns;
+	element_t *coefficients;
+} block_linear_system_t[1];
+
+// e    	= challenge
+// k_i_#	= coefficients[row_starts[i] + #], the coefficient of column entry_columns[...] in row i
+// b_i  	= inst->public_values[rhs_indices[i]], or zero if rhs_indices[i] is -1
+// o_s_#	= inst->secret_openings[columns[#]]
+// C_s_#	= inst->secret_commitments[columns[#]]
+
+// Row i is weighted by e ^ (i + 1), so that the rows sum to a single equation:
+// a_#	= sum_i e ^ (i + 1) * k_i_#	(for each column)
+// d	= sum_i e ^ (i + 1) * b_i
+// If every row holds, prod (C_s_#) ^ a_# = g ^ d * h ^ (sum a_# * o_s_#), and if any row
+// fails, this fails for all but a few values of e, since it is a polynomial in e.
+
+// [r]	= h ^ r	= R
+
+// [r - (a_1 * o_s_1 + a_2 * o_s_2 + ...)] * (C_s_1) ^ a_1 * (C_s_2) ^ a_2 * ... * g ^ -d	= R
+
+void _linear_system_clear(block_ptr);
+int _linear_system_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _linear_system_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
+void _linear_system_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _linear_system_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+block_linear_system_ptr block_linear_system_base(proof_t proof, int rows, int num_columns, int num_entries) {
+	int i;
+	block_linear_system_ptr self = (block_linear_system_ptr)pbc_malloc(sizeof(block_linear_system_t));
+	self->base->clear = &_linear_system_clear;
+	self->base->write = &_linear_system_write;
+	self->base->codegen = NULL;
+	self->base->claim_gen = &_linear_system_claim_gen;
+	self->base->response_gen = &_linear_system_response_gen;
+	self->base->response_verify = &_linear_system_response_verify;
+	self->base->response_verify_batch = NULL;
+	self->base->response_verify_step = NULL;
+	self->base->verify_steps = 1;
+	self->base->supplement_type = (type_ptr)void_type;
+	self->base->claim_secret_type = (type_ptr)proof->Z_type;
+	self->base->claim_public_type = (type_ptr)proof->G_type;
+	self->base->response_type = (type_ptr)proof->Z_type;
+	self->base->kind = BLOCK_LINEAR_SYSTEM;
+	self->rows = rows;
+	self->num_columns = num_columns;
+	self->num_entries = num_entries;
+	self->columns = (long*)pbc_malloc(sizeof(long) * num_columns);
+	self->rhs_indices = (long*)pbc_malloc(sizeof(long) * rows);
+	self->row_starts = (int*)pbc_malloc(sizeof(int) * (rows + 1));
+	self->entry_columns = (int*)pbc_malloc(sizeof(int) * (num_entries > 0 ? num_entries : 1));
+	self->coefficients = (element_t*)pbc_malloc(sizeof(element_t) * (num_entries > 0 ? num_entries : 1));
+	for (i = 0; i < num_entries; i++) element_init(self->coefficients[i], proof->Z_type->field);
+	self->row_starts[0] = 0;
+	block_insert(proof, (block_ptr)self);
+	return self;
+}
+
+void _linear_system_clear(block_ptr block) {
+	block_linear_system_ptr self = (block_linear_system_ptr)block;
+	int i;
+	for (i = 0; i < self->num_entries; i++) element_clear(self->coefficients[i]);
+	pbc_free(self->columns);
+	pbc_free(self->rhs_indices);
+	pbc_free(self->row_starts);
+	pbc_free(self->entry_columns);
+	pbc_free(self->coefficients);
+	pbc_free(self);
+}
+
+int _linear_system_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_linear_system_ptr self = (block_linear_system_ptr)block;
+	int i, j;
+	u64_write(self->rows, stream);
+	u64_write(self->num_columns, stream);
+	u64_write(self->num_entries, stream);
+	for (j = 0; j < self->num_columns; j++) u64_write(self->columns[j], stream);
+	for (i = 0; i < self->rows; i++) {
+		u64_write(self->row_starts[i + 1] - self->row_starts[i], stream);
+		u64_write((uint64_t)(self->rhs_indices[i] + 1), stream);
+		for (j = self->row_starts[i]; j < self->row_starts[i + 1]; j++) {
+			u64_write(self->entry_columns[j], stream);
+			element_write(proof->Z_type->field, self->coefficients[j], stream);
+		}
+	}
+	return 1;
+}
+
+int _linear_system_read(proof_t proof, FILE* stream) {
+	int i, j; long column; uint64_t rows, num_columns, num_entries, length, rhs;
+	if (u64_read(&rows, stream) != 8 || rows == 0 || rows > INT_MAX / 8) return 0;
+	if (u64_read(&num_columns, stream) != 8 || num_columns == 0 || num_columns > INT_MAX / 8) return 0;
+	if (u64_read(&num_entries, stream) != 8 || num_entries > INT_MAX / 8) return 0;
+	block_linear_system_ptr self = block_linear_system_base(proof, (int)rows, (int)num_columns, (int)num_entries);
+	for (j = 0; j < (int)num_columns; j++) {
+		if (!secret_index_read(proof, &self->columns[j], stream)) return 0;
+	}
+	for (i = 0; i < (int)rows; i++) {
+		if (u64_read(&length, stream) != 8 || length > num_entries - self->row_starts[i]) return 0;
+		self->row_starts[i + 1] = self->row_starts[i] + (int)length;
+		if (u64_read(&rhs, stream) != 8 || rhs > (uint64_t)proof->num_public) return 0;
+		self->rhs_indices[i] = (long)rhs - 1;
+		for (j = self->row_starts[i]; j < self->row_starts[i + 1]; j++) {
+			if (!index_read(&column, (long)num_columns, stream)) return 0;
+			self->entry_columns[j] = (int)column;
+			if (!element_read(proof->Z_type->field, self->coefficients[j], stream)) return 0;
+		}
+	}
+	return self->row_starts[rows] == (int)num_entries;
+}
+
+void _linear_system_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
+	element_ptr r = get_element((element_type_ptr)proof->Z_type, claim_secret);
+	element_ptr R = get_element((element_type_ptr)proof->G_type, claim_public);
+	
+	// R = h ^ r
+	element_random(r);
+	proof_pow_h(proof, R, r);
+}
+
+void _linear_system_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
+	block_linear_system_ptr self = (block_linear_system_ptr)block;
+	int i, j;
+	element_ptr r = get_element((element_type_ptr)proof->Z_type, claim_secret);
+	element_ptr x = get_element((element_type_ptr)proof->Z_type, response);
+	
+	// x = r - sum_i e ^ (i + 1) * (k_i_1 * o_s_1 + k_i_2 * o_s_2 + ...)
+	element_ptr weight = inst->scratch_Z[0];
+	element_ptr term = inst->scratch_Z[1];
+	element_t row; element_init(row, proof->Z_type->field);
+	element_set0(x);
+	element_set1(weight);
+	for (i = 0; i < self->rows; i++) {
+		element_mul(weight, weight, challenge);
+		element_set0(row);
+		for (j = self->row_starts[i]; j < self->row_starts[i + 1]; j++) {
+			element_mul(term, self->coefficients[j], inst->secret_openings[self->columns[self->entry_columns[j]]]);
+			element_add(row, row, term);
+		}
+		element_mul(row, row, weight);
+		element_add(x, x, row);
+	}
+	element_sub(x, r, x);
+	element_clear(row);
+}
+
+int _linear_system_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	block_linear_system_ptr self = (block_linear_system_ptr)block;
+	int i, j; int num_columns = self->num_columns;
+	element_ptr R = get_element((element_type_ptr)proof->G_type, claim_public);
+	element_ptr x = get_element((element_type_ptr)proof->Z_type, response);
+	
+	// Verify [x] * (C_s_1) ^ a_1 * (C_s_2) ^ a_2 * ... * g ^ -d * R ^ -1 = 1 with a single
+	// multi-exponentiation, with the exponents a_#, then -d, x and -1.
+	int num_terms = num_columns + 3;
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * num_terms);
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * num_terms);
+	element_t *scalars = (element_t*)pbc_malloc(sizeof(element_t) * num_terms);
+	for (i = 0; i < num_terms; i++) {
+		element_init(scalars[i], proof->Z_type->field);
+		element_set0(scalars[i]);
+		exps[i] = scalars[i];
+	}
+	element_ptr d = scalars[num_columns];
+	element_ptr weight = inst->scratch_Z[0];
+	element_ptr term = inst->scratch_Z[1];
+	element_set1(weight);
+	for (i = 0; i < self->rows; i++) {
+		element_mul(weight, weight, challenge);
+		for (j = self->row_starts[i]; j < self->row_starts[i + 1]; j++) {
+			element_mul(term, self->coefficients[j], weight);
+			element_add(scalars[self->entry_columns[j]], scalars[self->entry_columns[j]], term);
+		}
+		if (self->rhs_indices[i] >= 0) {
+			element_mul(term, inst->public_values[self->rhs_indices[i]], weight);
+			element_add(d, d, term);
+		}
+	}
+	for (j = 0; j < num_columns; j++) bases[j] = inst->secret_commitments[self->columns[j]];
+	element_neg(d, d);
+	bases[num_columns] = proof->g;
+	element_set(scalars[num_columns + 1], x);
+	bases[num_columns + 1] = proof->h;
+	element_set1(scalars[num_columns + 2]);
+	element_neg(scalars[num_columns + 2], scalars[num_columns + 2]);
+	bases[num_columns + 2] = R;
+	
+	element_ptr result = inst->scratch_G[0];
+	element_multi_pow(result, num_terms, bases, exps);
+	int valid = element_is1(result);
+	
+	for (i = 0; i < num_terms; i++) element_clear(scalars[i]);
+	pbc_free(scalars);
+	pbc_free(bases);
+	pbc_free(exps);
+	return valid;
+}
+
+void require_linear_system(proof_t proof, int rows, int count, element_t* coeffs, var_t* vars, var_t* rhs) {
+	int i, j; int num_entries = 0;
+	assert(rows > 0 && count > 0);
+	for (i = 0; i < rows * count; i++) {
+		if (!element_is0(coeffs[i])) num_entries++;
+	}
+	block_linear_system_ptr self = block_linear_system_base(proof, rows, count, num_entries);
+	for (j = 0; j < count; j++) self->columns[j] = var_secret_index(proof, vars[j]);
+	for (i = 0, num_entries = 0; i < rows; i++) {
+		for (j = 0; j < count; j++) {
+			if (element_is0(coeffs[i * count + j])) continue;
+			self->entry_columns[num_entries] = j;
+			element_set(self->coefficients[num_entries], coeffs[i * count + j]);
+			num_entries++;
+		}
+		self->row_starts[i + 1] = num_entries;
+		if (rhs != NULL) {
+			assert(var_is_public(rhs[i]));
+			self->rhs_indices[i] = var_index(rhs[i]);
+		} else {
+			self->rhs_indices[i] = -1;
+		}
+	}
+}
+
 /***************************************************
 * product
 *
@@ -498,21 +1143,30 @@ typedef struct block_product_s {
 // [(f_1, o_f_1, o_p - o_f_2 * f_1)]	= (C_f_1, C_p)
 
 void _product_clear(block_ptr);
+int _product_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _product_codegen(block_ptr, proof_t, codegen_ptr);
 void _product_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
 void _product_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
 int _product_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+void _product_response_verify_batch(block_ptr, proof_t, batch_ptr, data_ptr*, data_ptr*, int*);
 void block_product(proof_t proof, long product_index, long factor_1_index, long factor_2_index) {
 	block_product_ptr self = (block_product_ptr)pbc_malloc(sizeof(block_product_t));
 	array_type_init(self->Zx_type, (type_ptr)proof->Z_type, 3);
 	array_type_init(self->Gx_type, (type_ptr)proof->G_type, 2);
 	self->base->clear = &_product_clear;
+	self->base->write = &_product_write;
+	self->base->codegen = &_product_codegen;
 	self->base->claim_gen = &_product_claim_gen;
 	self->base->response_gen = &_product_response_gen;
 	self->base->response_verify = &_product_response_verify;
+	self->base->response_verify_batch = &_product_response_verify_batch;
+	self->base->response_verify_step = NULL;
+	self->base->verify_steps = 1;
 	self->base->supplement_type = (type_ptr)void_type;
 	self->base->claim_secret_type = (type_ptr)self->Zx_type;
 	self->base->claim_public_type = (type_ptr)self->Gx_type;
 	self->base->response_type = (type_ptr)self->Zx_type;
+	self->base->kind = BLOCK_PRODUCT;
 	self->product_index = product_index;
 	self->factor_1_index = factor_1_index;
 	self->factor_2_index = factor_2_index;
@@ -523,6 +1177,61 @@ void _product_clear(block_ptr block) {
 	pbc_free((block_product_ptr)block);
 }
 
+int _product_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_product_ptr self = (block_product_ptr)block;
+	u64_write(self->product_index, stream);
+	u64_write(self->factor_1_index, stream);
+	u64_write(self->factor_2_index, stream);
+	return 1;
+}
+
+int _product_read(proof_t proof, FILE* stream) {
+	long product_index, factor_1_index, factor_2_index;
+	if (!secret_index_read(proof, &product_index, stream)) return 0;
+	if (!secret_index_read(proof, &factor_1_index, stream)) return 0;
+	if (!secret_index_read(proof, &factor_2_index, stream)) return 0;
+	block_product(proof, product_index, factor_1_index, factor_2_index);
+	return 1;
+}
+
+void _product_codegen(block_ptr block, proof_t proof, codegen_ptr gen) {
+	block_product_ptr self = (block_product_ptr)block;
+	FILE* out = gen->stream;
+	size_t cs = gen->base[PART_CLAIM_SECRET];
+	size_t cp = gen->base[PART_CLAIM_PUBLIC];
+	size_t rs = gen->base[PART_RESPONSE];
+	if (gen->stage != CODEGEN_BODY) return;
+	switch (gen->routine) {
+		case CODEGEN_CLAIM_GEN:
+			fprintf(out, "\telement_random(CS(%zu));\n", cs);
+			fprintf(out, "\telement_random(CS(%zu));\n", cs + 1);
+			fprintf(out, "\tproof_pow_gh(proof, CP(%zu), CS(%zu), CS(%zu));\n", cp, cs, cs + 1);
+			fprintf(out, "\telement_random(CS(%zu));\n", cs + 2);
+			fprintf(out, "\telement_pow2_zn(CP(%zu), SC(%ld), CS(%zu), proof->h, CS(%zu));\n", cp + 1, self->factor_2_index, cs, cs + 2);
+			break;
+		case CODEGEN_RESPONSE_GEN:
+			fprintf(out, "\telement_mul(RS(%zu), SV(%ld), challenge);\n", rs, self->factor_1_index);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs, rs, cs);
+			fprintf(out, "\telement_mul(RS(%zu), SO(%ld), challenge);\n", rs + 1, self->factor_1_index);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs + 1, rs + 1, cs + 1);
+			fprintf(out, "\telement_mul(RS(%zu), SO(%ld), SV(%ld));\n", rs + 2, self->factor_2_index, self->factor_1_index);
+			fprintf(out, "\telement_sub(RS(%zu), SO(%ld), RS(%zu));\n", rs + 2, self->product_index, rs + 2);
+			fprintf(out, "\telement_mul(RS(%zu), RS(%zu), challenge);\n", rs + 2, rs + 2);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs + 2, rs + 2, cs + 2);
+			break;
+		case CODEGEN_RESPONSE_VERIFY:
+			fprintf(out, "\tproof_pow_gh(proof, G0, RS(%zu), RS(%zu));\n", rs, rs + 1);
+			fprintf(out, "\telement_pow_zn(G1, SC(%ld), challenge);\n", self->factor_1_index);
+			fprintf(out, "\telement_mul(G1, G1, CP(%zu));\n", cp);
+			fprintf(out, "\tif (element_cmp(G0, G1)) goto invalid;\n");
+			fprintf(out, "\telement_pow2_zn(G0, SC(%ld), RS(%zu), proof->h, RS(%zu));\n", self->factor_2_index, rs, rs + 2);
+			fprintf(out, "\telement_pow_zn(G1, SC(%ld), challenge);\n", self->product_index);
+			fprintf(out, "\telement_mul(G1, G1, CP(%zu));\n", cp + 1);
+			fprintf(out, "\tif (element_cmp(G0, G1)) goto invalid;\n");
+			break;
+	}
+}
+
 void _product_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
 	block_product_ptr self = (block_product_ptr)block;
 	element_ptr r_1 = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, claim_secret, 0));
@@ -534,7 +1243,7 @@ void _product_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr cl
 	// R_1 = g ^ r_1 * h ^ r_2
 	element_random(r_1);
 	element_random(r_2);
-	element_pow2_zn(R_1, proof->g, r_1, proof->h, r_2);
+	proof_pow_gh(proof, R_1, r_1, r_2);
 	
 	// R_2 = C_f_2 ^ r_1 * h ^ r_3
 	element_random(r_3);
@@ -574,27 +1283,51 @@ int _product_response_verify(block_ptr block, proof_t proof, inst_t inst, data_p
 	element_ptr x_3 = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response, 2));
 	
 	// Verify g ^ x_1 * h ^ x_2 = C_f_1 ^ e * R_1
-	int result = 1;
-	element_t left; element_init(left, proof->G_type->field);
-	element_t right; element_init(right, proof->G_type->field);
-	element_pow2_zn(left, proof->g, x_1, proof->h, x_2);
+	element_ptr left = inst->scratch_G[0];
+	element_ptr right = inst->scratch_G[1];
+	proof_pow_gh(proof, left, x_1, x_2);
 	element_pow_zn(right, inst->secret_commitments[self->factor_1_index], challenge);
 	element_mul(right, right, R_1);
-	if (element_cmp(left, right)) {
-		result = 0;
-		goto end;
-	}
+	if (element_cmp(left, right)) return 0;
 	
 	// Verify C_f_2 ^ x_1 * h ^ x_3 = C_p ^ e * R_2
 	element_pow2_zn(left, inst->secret_commitments[self->factor_2_index], x_1, proof->h, x_3);
 	element_pow_zn(right, inst->secret_commitments[self->product_index], challenge);
 	element_mul(right, right, R_2);
-	result = !element_cmp(left, right);
+	return !element_cmp(left, right);
+}
 
-end:
-	element_clear(left);
-	element_clear(right);
-	return result;
+void _product_response_verify_batch(block_ptr block, proof_t proof, batch_ptr batch, data_ptr* claim_public, data_ptr* response, int* valid) {
+	block_product_ptr self = (block_product_ptr)block;
+	int i; int count = batch->count;
+	element_t *C_p = batch->secret_commitments[self->product_index];
+	element_t *C_f_1 = batch->secret_commitments[self->factor_1_index];
+	element_t *C_f_2 = batch->secret_commitments[self->factor_2_index];
+	element_ptr left = batch->scratch_G[0];
+	element_ptr right = batch->scratch_G[1];
+	for (i = 0; i < count; i++) {
+		if (!valid[i]) continue;
+		element_ptr R_1 = get_element((element_type_ptr)proof->G_type, get_item((array_type_ptr)self->Gx_type, claim_public[i], 0));
+		element_ptr R_2 = get_element((element_type_ptr)proof->G_type, get_item((array_type_ptr)self->Gx_type, claim_public[i], 1));
+		element_ptr x_1 = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response[i], 0));
+		element_ptr x_2 = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response[i], 1));
+		element_ptr x_3 = get_element((element_type_ptr)proof->Z_type, get_item((array_type_ptr)self->Zx_type, response[i], 2));
+		
+		// Verify g ^ x_1 * h ^ x_2 = C_f_1 ^ e * R_1
+		proof_pow_gh(proof, left, x_1, x_2);
+		element_pow_zn(right, C_f_1[i], batch->challenges[i]);
+		element_mul(right, right, R_1);
+		if (element_cmp(left, right)) {
+			valid[i] = 0;
+			continue;
+		}
+		
+		// Verify C_f_2 ^ x_1 * h ^ x_3 = C_p ^ e * R_2
+		element_pow2_zn(left, C_f_2[i], x_1, proof->h, x_3);
+		element_pow_zn(right, C_p[i], batch->challenges[i]);
+		element_mul(right, right, R_2);
+		valid[i] = !element_cmp(left, right);
+	}
 }
 
 void require_mul(proof_t proof, var_t product, var_t factor_1, var_t factor_2) {
@@ -603,3 +1336,496 @@ void require_mul(proof_t proof, var_t product, var_t factor_1, var_t factor_2) {
 		var_secret_index(proof, factor_1),
 		var_secret_index(proof, factor_2));
 }
+
+/***************************************************
+* products
+*
+* Verifies many product relationships at once, as
+* the product block does for one, checking them all
+* with a single multi-exponentiation.
+****************************************************/
+
+typedef struct block_products_s *block_products_ptr;
+typedef struct block_products_s {
+	block_t base;
+	array_type_t Zx_type;
+	array_type_t Gx_type;
+	int count;
+	long *product_indices;
+	long *factor_1_indices;
+	long *factor_2_indices;
+} block_products_t[1];
+
+// The claims, responses and checks for triple # are those of the product block, with the
+// parts of all triples stored together: [r_1 ..., r_2 ..., r_3 ...], [R_1 ..., R_2 ...].
+
+// With random weights u_# and v_#, the checks combine into
+// g ^ (sum u_# * x_1_#) * h ^ (sum u_# * x_2_# + v_# * x_3_#) * prod C_f_2_# ^ (v_# * x_1_#)
+// 	= prod C_f_1_# ^ (e * u_#) * R_1_# ^ u_# * C_p_# ^ (e * v_#) * R_2_# ^ v_#
+// which fails with negligible probability if any of them fails. A verifier task checks
+// PRODUCTS_STEP_SIZE triples per step the same way, so that each step is bounded.
+#define PRODUCTS_STEP_SIZE 64
+
+void _products_clear(block_ptr);
+int _products_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _products_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
+void _products_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _products_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _products_response_verify_step(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr, int);
+block_products_ptr block_products_base(proof_t proof, int count) {
+	block_products_ptr self = (block_products_ptr)pbc_malloc(sizeof(block_products_t));
+	array_type_init(self->Zx_type, (type_ptr)proof->Z_type, 3 * count);
+	array_type_init(self->Gx_type, (type_ptr)proof->G_type, 2 * count);
+	self->base->clear = &_products_clear;
+	self->base->write = &_products_write;
+	self->base->codegen = NULL;
+	self->base->claim_gen = &_products_claim_gen;
+	self->base->response_gen = &_products_response_gen;
+	self->base->response_verify = &_products_response_verify;
+	self->base->response_verify_batch = NULL;
+	self->base->response_verify_step = &_products_response_verify_step;
+	self->base->verify_steps = (count + PRODUCTS_STEP_SIZE - 1) / PRODUCTS_STEP_SIZE;
+	self->base->supplement_type = (type_ptr)void_type;
+	self->base->claim_secret_type = (type_ptr)self->Zx_type;
+	self->base->claim_public_type = (type_ptr)self->Gx_type;
+	self->base->response_type = (type_ptr)self->Zx_type;
+	self->base->kind = BLOCK_PRODUCTS;
+	self->count = count;
+	self->product_indices = (long*)pbc_malloc(sizeof(long) * count);
+	self->factor_1_indices = (long*)pbc_malloc(sizeof(long) * count);
+	self->factor_2_indices = (long*)pbc_malloc(sizeof(long) * count);
+	block_insert(proof, (block_ptr)self);
+	return self;
+}
+
+void _products_clear(block_ptr block) {
+	block_products_ptr self = (block_products_ptr)block;
+	pbc_free(self->product_indices);
+	pbc_free(self->factor_1_indices);
+	pbc_free(self->factor_2_indices);
+	pbc_free(self);
+}
+
+int _products_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_products_ptr self = (block_products_ptr)block;
+	int i;
+	u64_write(self->count, stream);
+	for (i = 0; i < self->count; i++) {
+		u64_write(self->product_indices[i], stream);
+		u64_write(self->factor_1_indices[i], stream);
+		u64_write(self->factor_2_indices[i], stream);
+	}
+	return 1;
+}
+
+int _products_read(proof_t proof, FILE* stream) {
+	int i; uint64_t count;
+	if (u64_read(&count, stream) != 8 || count == 0 || count > INT_MAX / 3) return 0;
+	block_products_ptr self = block_products_base(proof, (int)count);
+	for (i = 0; i < (int)count; i++) {
+		if (!secret_index_read(proof, &self->product_indices[i], stream)) return 0;
+		if (!secret_index_read(proof, &self->factor_1_indices[i], stream)) return 0;
+		if (!secret_index_read(proof, &self->factor_2_indices[i], stream)) return 0;
+	}
+	return 1;
+}
+
+void _products_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
+	block_products_ptr self = (block_products_ptr)block;
+	int i; int count = self->count;
+	element_t *r = (element_t*)claim_secret;
+	element_t *R = (element_t*)claim_public;
+	
+	// Draw all of r_1, r_2 and r_3 in one pass.
+	for (i = 0; i < 3 * count; i++) element_random(r[i]);
+	
+	// R_1_# = g ^ r_1_# * h ^ r_2_#
+	for (i = 0; i < count; i++) proof_pow_gh(proof, R[i], r[i], r[count + i]);
+	
+	// R_2_# = C_f_2_# ^ r_1_# * h ^ r_3_#
+	for (i = 0; i < count; i++) {
+		element_pow2_zn(R[count + i], inst->secret_commitments[self->factor_2_indices[i]], r[i], proof->h, r[2 * count + i]);
+	}
+}
+
+void _products_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
+	block_products_ptr self = (block_products_ptr)block;
+	int i; int count = self->count;
+	element_t *r = (element_t*)claim_secret;
+	element_t *x = (element_t*)response;
+	
+	// x_1_# = e * f_1_# + r_1_#
+	for (i = 0; i < count; i++) {
+		element_mul(x[i], inst->secret_values[self->factor_1_indices[i]], challenge);
+		element_add(x[i], x[i], r[i]);
+	}
+	
+	// x_2_# = e * o_f_1_# + r_2_#
+	for (i = 0; i < count; i++) {
+		element_mul(x[count + i], inst->secret_openings[self->factor_1_indices[i]], challenge);
+		element_add(x[count + i], x[count + i], r[count + i]);
+	}
+	
+	// x_3_# = e(o_p_# - o_f_2_# * f_1_#) + r_3_#
+	for (i = 0; i < count; i++) {
+		element_ptr x_3 = x[2 * count + i];
+		element_mul(x_3, inst->secret_openings[self->factor_2_indices[i]], inst->secret_values[self->factor_1_indices[i]]);
+		element_sub(x_3, inst->secret_openings[self->product_indices[i]], x_3);
+		element_mul(x_3, x_3, challenge);
+		element_add(x_3, x_3, r[2 * count + i]);
+	}
+}
+
+// Checks the triples from start up to (but not including) end with one multi-exponentiation.
+int _products_check(block_products_ptr self, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response, int start, int end) {
+	int i; int count = self->count; int n = end - start;
+	element_t *R = (element_t*)claim_public;
+	element_t *x = (element_t*)response;
+	int num_terms = 5 * n + 2;
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * num_terms);
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * num_terms);
+	element_t *scalars = (element_t*)pbc_malloc(sizeof(element_t) * num_terms);
+	for (i = 0; i < num_terms; i++) {
+		element_init(scalars[i], proof->Z_type->field);
+		exps[i] = scalars[i];
+	}
+	element_ptr g_exp = scalars[5 * n];
+	element_ptr h_exp = scalars[5 * n + 1];
+	element_ptr term = inst->scratch_Z[0];
+	element_set0(g_exp);
+	element_set0(h_exp);
+	for (i = start; i < end; i++) {
+		int k = i - start;
+		element_ptr v_x = scalars[k];
+		element_ptr e_u = scalars[n + k];
+		element_ptr u = scalars[2 * n + k];
+		element_ptr e_v = scalars[3 * n + k];
+		element_ptr v = scalars[4 * n + k];
+		element_random(u);
+		element_random(v);
+		
+		// g ^ (u * x_1), h ^ (u * x_2 + v * x_3) and C_f_2 ^ (v * x_1)
+		element_mul(term, u, x[i]);
+		element_add(g_exp, g_exp, term);
+		element_mul(term, u, x[count + i]);
+		element_add(h_exp, h_exp, term);
+		element_mul(term, v, x[2 * count + i]);
+		element_add(h_exp, h_exp, term);
+		element_mul(v_x, v, x[i]);
+		bases[k] = inst->secret_commitments[self->factor_2_indices[i]];
+		
+		// C_f_1 ^ -(e * u) and R_1 ^ -u
+		element_neg(u, u);
+		element_mul(e_u, challenge, u);
+		bases[n + k] = inst->secret_commitments[self->factor_1_indices[i]];
+		bases[2 * n + k] = R[i];
+		
+		// C_p ^ -(e * v) and R_2 ^ -v
+		element_neg(v, v);
+		element_mul(e_v, challenge, v);
+		bases[3 * n + k] = inst->secret_commitments[self->product_indices[i]];
+		bases[4 * n + k] = R[count + i];
+	}
+	bases[5 * n] = proof->g;
+	bases[5 * n + 1] = proof->h;
+	
+	element_ptr result = inst->scratch_G[0];
+	element_multi_pow(result, num_terms, bases, exps);
+	int valid = element_is1(result);
+	
+	for (i = 0; i < num_terms; i++) element_clear(scalars[i]);
+	pbc_free(scalars);
+	pbc_free(bases);
+	pbc_free(exps);
+	return valid;
+}
+
+int _products_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	block_products_ptr self = (block_products_ptr)block;
+	return _products_check(self, proof, inst, claim_public, challenge, response, 0, self->count);
+}
+
+int _products_response_verify_step(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response, int step) {
+	block_products_ptr self = (block_products_ptr)block;
+	int start = step * PRODUCTS_STEP_SIZE;
+	int end = self->count - start < PRODUCTS_STEP_SIZE ? self->count : start + PRODUCTS_STEP_SIZE;
+	return _products_check(self, proof, inst, claim_public, challenge, response, start, end);
+}
+
+void require_mul_many(proof_t proof, int count, var_t* products, var_t* factors_1, var_t* factors_2) {
+	int i;
+	block_products_ptr self = block_products_base(proof, count);
+	for (i = 0; i < count; i++) {
+		self->product_indices[i] = var_secret_index(proof, products[i]);
+		self->factor_1_indices[i] = var_secret_index(proof, factors_1[i]);
+		self->factor_2_indices[i] = var_secret_index(proof, factors_2[i]);
+	}
+}
+
+/***************************************************
+* inner_product
+*
+* Verifies that a secret variable is the inner product
+* of two vectors of secret variables, without committing
+* to the individual products.
+****************************************************/
+
+typedef struct block_inner_product_s *block_inner_product_ptr;
+typedef struct block_inner_product_s {
+	block_t base;
+	array_type_t Zx_type;
+	array_type_t Gx_type;
+	int count;
+	long product_index;
+	long *x_indices;
+	long *y_indices;
+} block_inner_product_t[1];
+
+// n    	= count
+// z    	= inst->secret_values[product_index]
+// o_z  	= inst->secret_openings[product_index]
+// C_z  	= inst->secret_commitments[product_index]
+// x_#  	= inst->secret_values[x_indices[#]]
+// o_x_#	= inst->secret_openings[x_indices[#]]
+// C_x_#	= inst->secret_commitments[x_indices[#]]
+// o_y_#	= inst->secret_openings[y_indices[#]]
+// C_y_#	= inst->secret_commitments[y_indices[#]]
+
+// C_y_0 ^ x_0 * C_y_1 ^ x_1 * ... = g ^ z * h ^ (o_y_0 * x_0 + o_y_1 * x_1 + ...), so
+// C_z = C_y_0 ^ x_0 * C_y_1 ^ x_1 * ... * h ^ d, where d = o_z - (o_y_0 * x_0 + o_y_1 * x_1 + ...)
+
+// [(r_#, s_#, r_d)]  	= (g ^ r_# * h ^ s_#, C_y_0 ^ r_0 * C_y_1 ^ r_1 * ... * h ^ r_d)	= (R_#, R)
+// [(x_#, o_x_#, d)]	= (C_x_#, C_z)
+
+void _inner_product_clear(block_ptr);
+int _inner_product_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _inner_product_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
+void _inner_product_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _inner_product_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _inner_product_response_verify_step(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr, int);
+block_inner_product_ptr block_inner_product_base(proof_t proof, int count) {
+	block_inner_product_ptr self = (block_inner_product_ptr)pbc_malloc(sizeof(block_inner_product_t));
+	array_type_init(self->Zx_type, (type_ptr)proof->Z_type, 2 * count + 1);
+	array_type_init(self->Gx_type, (type_ptr)proof->G_type, count + 1);
+	self->base->clear = &_inner_product_clear;
+	self->base->write = &_inner_product_write;
+	self->base->codegen = NULL;
+	self->base->claim_gen = &_inner_product_claim_gen;
+	self->base->response_gen = &_inner_product_response_gen;
+	self->base->response_verify = &_inner_product_response_verify;
+	self->base->response_verify_batch = NULL;
+	self->base->response_verify_step = &_inner_product_response_verify_step;
+	self->base->verify_steps = count + 1;
+	self->base->supplement_type = (type_ptr)void_type;
+	self->base->claim_secret_type = (type_ptr)self->Zx_type;
+	self->base->claim_public_type = (type_ptr)self->Gx_type;
+	self->base->response_type = (type_ptr)self->Zx_type;
+	self->base->kind = BLOCK_INNER_PRODUCT;
+	self->count = count;
+	self->x_indices = (long*)pbc_malloc(sizeof(long) * count);
+	self->y_indices = (long*)pbc_malloc(sizeof(long) * count);
+	block_insert(proof, (block_ptr)self);
+	return self;
+}
+
+void _inner_product_clear(block_ptr block) {
+	block_inner_product_ptr self = (block_inner_product_ptr)block;
+	pbc_free(self->x_indices);
+	pbc_free(self->y_indices);
+	pbc_free(self);
+}
+
+int _inner_product_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_inner_product_ptr self = (block_inner_product_ptr)block;
+	int i;
+	u64_write(self->count, stream);
+	u64_write(self->product_index, stream);
+	for (i = 0; i < self->count; i++) {
+		u64_write(self->x_indices[i], stream);
+		u64_write(self->y_indices[i], stream);
+	}
+	return 1;
+}
+
+int _inner_product_read(proof_t proof, FILE* stream) {
+	int i; uint64_t count;
+	if (u64_read(&count, stream) != 8 || count == 0 || count > INT_MAX / 2 - 1) return 0;
+	block_inner_product_ptr self = block_inner_product_base(proof, (int)count);
+	if (!secret_index_read(proof, &self->product_index, stream)) return 0;
+	for (i = 0; i < (int)count; i++) {
+		if (!secret_index_read(proof, &self->x_indices[i], stream)) return 0;
+		if (!secret_index_read(proof, &self->y_indices[i], stream)) return 0;
+	}
+	return 1;
+}
+
+// Computes C_y_0 ^ a_0 * C_y_1 ^ a_1 * ... * h ^ b for the given exponents, stored like
+// r_# and r_d (or x_# and x_d) in the given data.
+void _inner_product_pow(block_inner_product_ptr self, proof_t proof, inst_t inst, element_t out, data_ptr data) {
+	int i; int count = self->count;
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (count + 1));
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (count + 1));
+	for (i = 0; i < count; i++) {
+		bases[i] = inst->secret_commitments[self->y_indices[i]];
+		exps[i] = get_element(proof->Z_type, get_item(self->Zx_type, data, i));
+	}
+	bases[count] = proof->h;
+	exps[count] = get_element(proof->Z_type, get_item(self->Zx_type, data, 2 * count));
+	element_multi_pow(out, count + 1, bases, exps);
+	pbc_free(bases);
+	pbc_free(exps);
+}
+
+void _inner_product_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
+	block_inner_product_ptr self = (block_inner_product_ptr)block;
+	int i; int count = self->count;
+	for (i = 0; i < count; i++) {
+		element_ptr r = get_element(proof->Z_type, get_item(self->Zx_type, claim_secret, i));
+		element_ptr s = get_element(proof->Z_type, get_item(self->Zx_type, claim_secret, count + i));
+		element_ptr R = get_element(proof->G_type, get_item(self->Gx_type, claim_public, i));
+		
+		// R_# = g ^ r_# * h ^ s_#
+		element_random(r);
+		element_random(s);
+		proof_pow_gh(proof, R, r, s);
+	}
+	
+	// R = C_y_0 ^ r_0 * C_y_1 ^ r_1 * ... * h ^ r_d
+	element_random(get_element(proof->Z_type, get_item(self->Zx_type, claim_secret, 2 * count)));
+	_inner_product_pow(self, proof, inst, get_element(proof->G_type, get_item(self->Gx_type, claim_public, count)), claim_secret);
+}
+
+void _inner_product_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
+	block_inner_product_ptr self = (block_inner_product_ptr)block;
+	int i; int count = self->count;
+	element_ptr r_d = get_element(proof->Z_type, get_item(self->Zx_type, claim_secret, 2 * count));
+	element_ptr x_d = get_element(proof->Z_type, get_item(self->Zx_type, response, 2 * count));
+	element_ptr term = inst->scratch_Z[0];
+	
+	// x_d = o_y_0 * x_0 + o_y_1 * x_1 + ...
+	element_set0(x_d);
+	for (i = 0; i < count; i++) {
+		element_ptr x = inst->secret_values[self->x_indices[i]];
+		element_ptr r = get_element(proof->Z_type, get_item(self->Zx_type, claim_secret, i));
+		element_ptr s = get_element(proof->Z_type, get_item(self->Zx_type, claim_secret, count + i));
+		element_ptr x_x = get_element(proof->Z_type, get_item(self->Zx_type, response, i));
+		element_ptr x_o = get_element(proof->Z_type, get_item(self->Zx_type, response, count + i));
+		element_mul(term, inst->secret_openings[self->y_indices[i]], x);
+		element_add(x_d, x_d, term);
+		
+		// x_x_# = e * x_# + r_#
+		element_mul(x_x, challenge, x);
+		element_add(x_x, x_x, r);
+		
+		// x_o_# = e * o_x_# + s_#
+		element_mul(x_o, challenge, inst->secret_openings[self->x_indices[i]]);
+		element_add(x_o, x_o, s);
+	}
+	
+	// x_d = e(o_z - x_d) + r_d
+	element_sub(x_d, inst->secret_openings[self->product_index], x_d);
+	element_mul(x_d, x_d, challenge);
+	element_add(x_d, x_d, r_d);
+}
+
+// Performs one of the checks of an inner product block: the opening of x_# for steps
+// below the count, then the inner product itself.
+int _inner_product_check(block_inner_product_ptr self, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response, int step) {
+	int i = step; int count = self->count;
+	element_ptr left = inst->scratch_G[0];
+	element_ptr right = inst->scratch_G[1];
+	if (i < count) {
+		element_ptr x_x = get_element(proof->Z_type, get_item(self->Zx_type, response, i));
+		element_ptr x_o = get_element(proof->Z_type, get_item(self->Zx_type, response, count + i));
+		element_ptr R = get_element(proof->G_type, get_item(self->Gx_type, claim_public, i));
+		
+		// Verify g ^ x_x_# * h ^ x_o_# = C_x_# ^ e * R_#
+		proof_pow_gh(proof, left, x_x, x_o);
+		element_pow_zn(right, inst->secret_commitments[self->x_indices[i]], challenge);
+		element_mul(right, right, R);
+		return !element_cmp(left, right);
+	}
+	
+	// Verify C_y_0 ^ x_x_0 * C_y_1 ^ x_x_1 * ... * h ^ x_d = C_z ^ e * R
+	element_ptr R = get_element(proof->G_type, get_item(self->Gx_type, claim_public, count));
+	_inner_product_pow(self, proof, inst, left, response);
+	element_pow_zn(right, inst->secret_commitments[self->product_index], challenge);
+	element_mul(right, right, R);
+	return !element_cmp(left, right);
+}
+
+int _inner_product_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	block_inner_product_ptr self = (block_inner_product_ptr)block;
+	int step;
+	for (step = 0; step < block->verify_steps; step++) {
+		if (!_inner_product_check(self, proof, inst, claim_public, challenge, response, step)) return 0;
+	}
+	return 1;
+}
+
+int _inner_product_response_verify_step(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response, int step) {
+	return _inner_product_check((block_inner_product_ptr)block, proof, inst, claim_public, challenge, response, step);
+}
+
+void require_inner_product(proof_t proof, var_t product, int count, var_t* xs, var_t* ys) {
+	int i;
+	block_inner_product_ptr self = block_inner_product_base(proof, count);
+	self->product_index = var_secret_index(proof, product);
+	for (i = 0; i < count; i++) {
+		self->x_indices[i] = var_secret_index(proof, xs[i]);
+		self->y_indices[i] = var_secret_index(proof, ys[i]);
+	}
+}
+
+/***************************************************
+* range
+*
+* Bounds a variable by decomposing it into bits, each of which is
+* shown to be 0 or 1 by a product (b * b = b), and requiring
+* the weighted sum of the bits to equal the (offset) variable.
+****************************************************/
+
+// Requires that (negate ? -var : var) + offset lies in [0, 2 ^ bits).
+void _require_bits(proof_t proof, var_t var, int negate, long offset, int bits) {
+	int i;
+	var_t *vars = (var_t*)pbc_malloc(sizeof(var_t) * bits);
+	for (i = 0; i < bits; i++) vars[i] = var_secret(proof);
+	require_mul_many(proof, bits, vars, vars, vars);
+	computation_bits(proof, var, negate, offset, bits, vars);
+	
+	int count = bits + 1 + (offset != 0);
+	long index = var_secret_index(proof, var);
+	long one_index = offset != 0 ? var_secret_index(proof, var_const_si(proof, 1)) : 0;
+	block_wsum_zero_ptr self = block_wsum_zero_base(proof, count);
+	self->coefficients[0] = negate ? -1 : 1; self->indices[0] = index;
+	for (i = 0; i < bits; i++) {
+		self->coefficients[1 + i] = -(1L << i);
+		self->indices[1 + i] = var_index(vars[i]);
+	}
+	if (offset != 0) {
+		self->coefficients[1 + bits] = offset;
+		self->indices[1 + bits] = one_index;
+	}
+	pbc_free(vars);
+}
+
+void require_nonneg(proof_t proof, var_t var, int bits) {
+	assert(bits > 0 && bits <= BITS_MAX);
+	_require_bits(proof, var, 0, 0, bits);
+}
+
+void require_range(proof_t proof, var_t var, long low, long high) {
+	assert(low <= high);
+	
+	// The offset for var - low is -low, which is not a long for LONG_MIN.
+	assert(low > LONG_MIN);
+	unsigned long width = (unsigned long)high - (unsigned long)low;
+	int bits = 1;
+	while (bits < BITS_MAX && (width >> bits) != 0) bits++;
+	assert((width >> bits) == 0);
+	
+	// var - low and high - var are both in [0, 2 ^ bits), and since they sum to
+	// high - low without wrapping around, each is at most high - low.
+	_require_bits(proof, var, 0, -low, bits);
+	_require_bits(proof, var, 1, high, bits);
+}
@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_internal.h"
+#include "zkp_codegen.h"
+
+void _codegen_prelude(proof_t, const unsigned char*, const char*, FILE*);
+void _codegen_routine(proof_t, int, FILE*);
+int proof_codegen(proof_t proof, proof_refs_t refs, const char* name, FILE* stream) {
+	unsigned char digest[32];
+	assert(proof->plan != NULL);
+	if (!proof_digest(proof, refs, digest)) return 0;
+	_codegen_prelude(proof, digest, name, stream);
+	
+	fprintf(stream, "void %s_claim_gen(proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {\n", name);
+	_codegen_routine(proof, CODEGEN_CLAIM_GEN, stream);
+	fprintf(stream, "}\n\n");
+	
+	fprintf(stream, "void %s_response_gen(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {\n", name);
+	_codegen_routine(proof, CODEGEN_RESPONSE_GEN, stream);
+	fprintf(stream, "}\n\n");
+	
+	fprintf(stream, "int %s_response_verify(proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {\n", name);
+	fprintf(stream, "\tint result = 0;\n");
+	_codegen_routine(proof, CODEGEN_RESPONSE_VERIFY, stream);
+	fprintf(stream, "\treturn result;\n");
+	fprintf(stream, "}\n");
+	return !ferror(stream);
+}
+
+void _codegen_prelude(proof_t proof, const unsigned char* digest, const char* name, FILE* stream) {
+	int i, part; int count = proof->num_blocks;
+	fprintf(stream, "// Generated by proof_codegen. Do not edit.\n\n");
+	fprintf(stream, "#include <string.h>\n");
+	fprintf(stream, "#include <pbc.h>\n");
+	fprintf(stream, "#include \"zkp.h\"\n");
+	fprintf(stream, "#include \"zkp_internal.h\"\n\n");
+	fprintf(stream, "#define E(data, k) ((element_ptr)((char*)(data) + (k) * sizeof(element_t)))\n");
+	fprintf(stream, "#define CS(k) E(claim_secret, k)\n");
+	fprintf(stream, "#define CP(k) E(claim_public, k)\n");
+	fprintf(stream, "#define RS(k) E(response, k)\n");
+	fprintf(stream, "#define SUP(offset) inst_supplement(proof, inst, offset)\n");
+	fprintf(stream, "#define SV(i) inst->secret_values[i]\n");
+	fprintf(stream, "#define SO(i) inst->secret_openings[i]\n");
+	fprintf(stream, "#define SC(i) inst->secret_commitments[i]\n");
+	fprintf(stream, "#define PV(i) inst->public_values[i]\n\n");
+	
+	// The layout the routines were generated for, with offsets in elements.
+	fprintf(stream, "static const int %s_kinds[%d] = {", name, count);
+	for (i = 0; i < count; i++) fprintf(stream, "%s%d", i > 0 ? ", " : " ", proof->plan[i].kind);
+	fprintf(stream, " };\n\n");
+	fprintf(stream, "static const size_t %s_offsets[%d][PART_COUNT] = {\n", name, count);
+	for (i = 0; i < count; i++) {
+		fprintf(stream, "\t{");
+		for (part = 0; part < PART_COUNT; part++) {
+			assert(proof->plan[i].offsets[part] % sizeof(element_t) == 0);
+			fprintf(stream, "%s%zu", part > 0 ? ", " : " ", proof->plan[i].offsets[part] / sizeof(element_t));
+		}
+		fprintf(stream, " }%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(stream, "};\n\n");
+	
+	// The statement the routines were generated for, which fixes the variable indices and
+	// constants they use.
+	fprintf(stream, "static const unsigned char %s_digest[32] = {", name);
+	for (i = 0; i < 32; i++) fprintf(stream, "%s0x%02x", i == 0 ? " " : i % 8 == 0 ? ",\n\t" : ", ", digest[i]);
+	fprintf(stream, " };\n\n");
+	
+	fprintf(stream, "int %s_check(proof_t proof, proof_refs_t refs) {\n", name);
+	fprintf(stream, "\tint i, part;\n");
+	fprintf(stream, "\tunsigned char digest[32];\n");
+	fprintf(stream, "\tif (proof->plan == NULL || proof->num_blocks != %d) return 0;\n", count);
+	fprintf(stream, "\tif (proof->num_secret != %ld || proof->num_public != %ld) return 0;\n", proof->num_secret, proof->num_public);
+	fprintf(stream, "\tfor (i = 0; i < %d; i++) {\n", count);
+	fprintf(stream, "\t\tif (proof->plan[i].kind != %s_kinds[i]) return 0;\n", name);
+	fprintf(stream, "\t\tfor (part = 0; part < PART_COUNT; part++) {\n");
+	fprintf(stream, "\t\t\tif (proof->plan[i].offsets[part] != %s_offsets[i][part] * sizeof(element_t)) return 0;\n", name);
+	fprintf(stream, "\t\t}\n");
+	fprintf(stream, "\t}\n");
+	fprintf(stream, "\tif (!proof_digest(proof, refs, digest)) return 0;\n");
+	fprintf(stream, "\treturn !memcmp(digest, %s_digest, 32);\n", name);
+	fprintf(stream, "}\n\n");
+}
+
+void _codegen_fallback(int, int, FILE*);
+void _codegen_routine(proof_t proof, int routine, FILE* stream) {
+	int i, part; int count = proof->num_blocks;
+	codegen_t gen;
+	gen->stream = stream;
+	gen->routine = routine;
+	
+	// Shared temporaries, taken from the scratch space of the instance.
+	fprintf(stream, "\telement_ptr Z0 = inst->scratch_Z[0], Z1 = inst->scratch_Z[1];\n");
+	fprintf(stream, "\telement_ptr G0 = inst->scratch_G[0], G1 = inst->scratch_G[1];\n");
+	
+	// Each stage visits the blocks in execution order.
+	for (gen->stage = CODEGEN_DECLARE; gen->stage <= CODEGEN_CLEAR; gen->stage++) {
+		if (gen->stage == CODEGEN_CLEAR && routine == CODEGEN_RESPONSE_VERIFY) {
+			fprintf(stream, "\tresult = 1;\n");
+			fprintf(stream, "invalid:\n");
+		}
+		for (i = 0; i < count; i++) {
+			plan_entry_ptr entry = &proof->plan[proof->plan_order[i]];
+			gen->index = proof->plan_order[i];
+			for (part = 0; part < PART_COUNT; part++) gen->base[part] = entry->offsets[part] / sizeof(element_t);
+			if (gen->stage == CODEGEN_BODY) fprintf(stream, "\t\n\t// Block %d\n", gen->index);
+			if (entry->block->codegen != NULL) entry->block->codegen(entry->block, proof, gen);
+			else if (gen->stage == CODEGEN_BODY) _codegen_fallback(routine, gen->index, stream);
+		}
+		if (gen->stage == CODEGEN_BODY) fprintf(stream, "\t\n");
+	}
+}
+
+void _codegen_fallback(int routine, int index, FILE* stream) {
+	fprintf(stream, "\t{\n");
+	fprintf(stream, "\t\tplan_entry_ptr entry = &proof->plan[%d];\n", index);
+	switch (routine) {
+		case CODEGEN_CLAIM_GEN:
+			fprintf(stream, "\t\tentry->block->claim_gen(entry->block, proof, inst,\n");
+			fprintf(stream, "\t\t\tget_block_part(entry, PART_CLAIM_SECRET, claim_secret),\n");
+			fprintf(stream, "\t\t\tget_block_part(entry, PART_CLAIM_PUBLIC, claim_public));\n");
+			break;
+		case CODEGEN_RESPONSE_GEN:
+			fprintf(stream, "\t\tentry->block->response_gen(entry->block, proof, inst,\n");
+			fprintf(stream, "\t\t\tget_block_part(entry, PART_CLAIM_SECRET, claim_secret), challenge,\n");
+			fprintf(stream, "\t\t\tget_block_part(entry, PART_RESPONSE, response));\n");
+			break;
+		case CODEGEN_RESPONSE_VERIFY:
+			fprintf(stream, "\t\tif (!entry->block->response_verify(entry->block, proof, inst,\n");
+			fprintf(stream, "\t\t\tget_block_part(entry, PART_CLAIM_PUBLIC, claim_public), challenge,\n");
+			fprintf(stream, "\t\t\tget_block_part(entry, PART_RESPONSE, response))) goto invalid;\n");
+			break;
+	}
+	fprintf(stream, "\t}\n");
+}
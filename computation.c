@@ -1,10 +1,15 @@
 #include <assert.h>
+#include <string.h>
 #include <pbc.h>
 #include "zkp_io.h"
 #include "zkp_proof.h"
 #include "zkp_internal.h"
 
+// The smallest number of computations in a level for it to be run in parallel.
+#define COMPUTATION_PARALLEL_MIN 64
+
 void computation_insert(proof_t proof, computation_ptr computation) {
+	assert(proof->computation_order == NULL);
 	if (proof->last_computation == NULL) {
 		proof->first_computation = computation;
 	} else {
@@ -17,18 +22,117 @@ void computation_insert(proof_t proof, computation_ptr computation) {
 void computations_clear(proof_t proof) {
 	computation_ptr current = proof->first_computation;
 	while (current != NULL) {
+		computation_ptr next = current->next;
 		current->clear(current);
-		current = current->next;
+		current = next;
+	}
+	if (proof->computation_order != NULL) {
+		pbc_free(proof->computation_order);
+		pbc_free(proof->level_starts);
+	}
+}
+
+void computations_finalize(proof_t proof) {
+	int i, j; int count = 0; int num_levels = 0;
+	long num_vars = proof->num_secret + proof->num_public;
+	computation_ptr current;
+	for (current = proof->first_computation; current != NULL; current = current->next) count++;
+	
+	// A computation must come after the last computation that wrote any of its inputs or
+	// outputs, and after every computation that read one of its outputs.
+	int *write_level = (int*)pbc_malloc(sizeof(int) * (num_vars > 0 ? num_vars : 1));
+	int *read_level = (int*)pbc_malloc(sizeof(int) * (num_vars > 0 ? num_vars : 1));
+	int *levels = (int*)pbc_malloc(sizeof(int) * (count > 0 ? count : 1));
+	for (i = 0; i < num_vars; i++) write_level[i] = read_level[i] = -1;
+	for (i = 0, current = proof->first_computation; current != NULL; i++, current = current->next) {
+		int level = 0;
+		for (j = 0; j < current->num_inputs; j++) {
+			long var = var_dirty_index(proof, current->inputs[j]);
+			if (write_level[var] + 1 > level) level = write_level[var] + 1;
+		}
+		for (j = 0; j < current->num_outputs; j++) {
+			long var = var_dirty_index(proof, current->outputs[j]);
+			if (write_level[var] + 1 > level) level = write_level[var] + 1;
+			if (read_level[var] + 1 > level) level = read_level[var] + 1;
+		}
+		for (j = 0; j < current->num_inputs; j++) {
+			long var = var_dirty_index(proof, current->inputs[j]);
+			if (level > read_level[var]) read_level[var] = level;
+		}
+		for (j = 0; j < current->num_outputs; j++) {
+			write_level[var_dirty_index(proof, current->outputs[j])] = level;
+		}
+		levels[i] = level;
+		if (level + 1 > num_levels) num_levels = level + 1;
+	}
+	
+	// Order computations by level, keeping insertion order within each level.
+	proof->num_levels = num_levels;
+	proof->level_starts = (int*)pbc_malloc(sizeof(int) * (num_levels + 1));
+	proof->computation_order = (computation_ptr*)pbc_malloc(sizeof(computation_ptr) * (count > 0 ? count : 1));
+	for (i = 0; i <= num_levels; i++) proof->level_starts[i] = 0;
+	for (i = 0; i < count; i++) proof->level_starts[levels[i] + 1]++;
+	for (i = 0; i < num_levels; i++) proof->level_starts[i + 1] += proof->level_starts[i];
+	int *next = (int*)pbc_malloc(sizeof(int) * (num_levels > 0 ? num_levels : 1));
+	for (i = 0; i < num_levels; i++) next[i] = proof->level_starts[i];
+	for (i = 0, current = proof->first_computation; current != NULL; i++, current = current->next) {
+		proof->computation_order[next[levels[i]]++] = current;
+	}
+	pbc_free(next);
+	pbc_free(write_level);
+	pbc_free(read_level);
+	pbc_free(levels);
+}
+
+int _set_read(proof_t, FILE*);
+int _mov_read(proof_t, FILE*);
+int _bits_read(proof_t, FILE*);
+int computation_read(proof_t proof, int kind, FILE* stream) {
+	switch (kind) {
+		case COMPUTATION_SET: return _set_read(proof, stream);
+		case COMPUTATION_MOV: return _mov_read(proof, stream);
+		case COMPUTATION_BITS: return _bits_read(proof, stream);
+	}
+	return 0;
+}
+
+// Indicates whether any input or output of a computation has changed in an instance.
+int _computation_dirty(proof_t proof, inst_t inst, computation_ptr computation) {
+	int i;
+	for (i = 0; i < computation->num_inputs; i++) {
+		if (inst->dirty[var_dirty_index(proof, computation->inputs[i])]) return 1;
+	}
+	for (i = 0; i < computation->num_outputs; i++) {
+		if (inst->dirty[var_dirty_index(proof, computation->outputs[i])]) return 1;
 	}
+	return 0;
 }
 
 void inst_update(proof_t proof, inst_t inst) {
-	computation_ptr current = proof->first_computation;
-	while(current != NULL) {
-		if (!current->is_secret || inst->secret_values != NULL)
-			current->apply(current, proof, inst);
-		current = current->next;
+	if (proof->computation_order != NULL) {
+		int level;
+		for (level = 0; level < proof->num_levels; level++) {
+			int i; int start = proof->level_starts[level]; int end = proof->level_starts[level + 1];
+			
+			// Computations within a level are independent, but most are cheap, so only
+			// large levels are worth spreading over threads.
+			#pragma omp parallel for if (end - start >= COMPUTATION_PARALLEL_MIN)
+			for (i = start; i < end; i++) {
+				computation_ptr current = proof->computation_order[i];
+				if ((!current->is_secret || inst->secret_values != NULL) && _computation_dirty(proof, inst, current))
+					current->apply(current, proof, inst);
+			}
+		}
+	} else {
+		computation_ptr current = proof->first_computation;
+		while(current != NULL) {
+			if ((!current->is_secret || inst->secret_values != NULL) && _computation_dirty(proof, inst, current))
+				current->apply(current, proof, inst);
+			current = current->next;
+		}
 	}
+	inst_commit_stale(proof, inst);
+	memset(inst->dirty, 0, proof->num_secret + proof->num_public);
 }
 
 /***************************************************
@@ -46,11 +150,18 @@ typedef struct computation_set_s {
 
 void _set_clear(computation_ptr computation);
 void _set_apply(computation_ptr computation, proof_t proof, inst_t inst);
+void _set_write(computation_ptr computation, proof_t proof, FILE* stream);
 computation_set_ptr computation_set_base(proof_t proof, var_t var) {
 	computation_set_ptr self = (computation_set_ptr)pbc_malloc(sizeof(computation_set_t));
 	self->base->clear = &_set_clear;
 	self->base->apply = &_set_apply;
+	self->base->write = &_set_write;
+	self->base->kind = COMPUTATION_SET;
 	self->base->is_secret = var_is_secret(var);
+	self->base->num_inputs = 0;
+	self->base->inputs = NULL;
+	self->base->num_outputs = 1;
+	self->base->outputs = &self->var;
 	self->var = var;
 	element_init(self->value, proof->Z_type->field);
 	computation_insert(proof, self->base);
@@ -65,7 +176,20 @@ void _set_clear(computation_ptr computation) {
 
 void _set_apply(computation_ptr computation, proof_t proof, inst_t inst) {
 	computation_set_ptr self = (computation_set_ptr)computation;
-	inst_var_set(proof, inst, self->var, self->value);
+	inst_var_assign(proof, inst, self->var, self->value);
+}
+
+void _set_write(computation_ptr computation, proof_t proof, FILE* stream) {
+	computation_set_ptr self = (computation_set_ptr)computation;
+	u64_write(self->var, stream);
+	element_write(proof->Z_type->field, self->value, stream);
+}
+
+int _set_read(proof_t proof, FILE* stream) {
+	var_t var;
+	if (u64_read(&var, stream) != 8 || !var_valid(proof, var)) return 0;
+	computation_set_ptr self = computation_set_base(proof, var);
+	return element_read(proof->Z_type->field, self->value, stream) > 0;
 }
 
 
@@ -117,11 +241,18 @@ typedef struct computation_mov_s {
 
 void _mov_clear(computation_ptr computation);
 void _mov_apply(computation_ptr computation, proof_t proof, inst_t inst);
+void _mov_write(computation_ptr computation, proof_t proof, FILE* stream);
 void computation_mov(proof_t proof, var_t dest, var_t src) {
 	computation_mov_ptr self = (computation_mov_ptr)pbc_malloc(sizeof(computation_mov_t));
 	self->base.clear = &_mov_clear;
 	self->base.apply = &_mov_apply;
+	self->base.write = &_mov_write;
+	self->base.kind = COMPUTATION_MOV;
 	self->base.is_secret = var_is_secret(dest) || var_is_secret(src);
+	self->base.num_inputs = 1;
+	self->base.inputs = &self->src;
+	self->base.num_outputs = 1;
+	self->base.outputs = &self->dest;
 	self->dest = dest;
 	self->src = src;
 	computation_insert(proof, &self->base);
@@ -134,5 +265,110 @@ void _mov_clear(computation_ptr computation) {
 
 void _mov_apply(computation_ptr computation, proof_t proof, inst_t inst) {
 	computation_mov_ptr self = (computation_mov_ptr)computation;
-	inst_var_set(proof, inst, self->dest, inst_var_get(proof, inst, self->src));
+	inst_var_assign(proof, inst, self->dest, inst_var_get(proof, inst, self->src));
+}
+
+void _mov_write(computation_ptr computation, proof_t proof, FILE* stream) {
+	computation_mov_ptr self = (computation_mov_ptr)computation;
+	u64_write(self->dest, stream);
+	u64_write(self->src, stream);
+}
+
+int _mov_read(proof_t proof, FILE* stream) {
+	var_t dest, src;
+	if (u64_read(&dest, stream) != 8 || !var_valid(proof, dest)) return 0;
+	if (u64_read(&src, stream) != 8 || !var_valid(proof, src)) return 0;
+	computation_mov(proof, dest, src);
+	return 1;
+}
+
+/***************************************************
+* bits
+*
+* Decomposes an offset variable into secret bits.
+****************************************************/
+
+typedef struct computation_bits_s *computation_bits_ptr;
+typedef struct computation_bits_s {
+	struct computation_s base;
+	var_t src;
+	int negate;
+	long offset;
+	var_t *bits;
+} computation_bits_t[1];
+
+void _bits_clear(computation_ptr computation);
+void _bits_apply(computation_ptr computation, proof_t proof, inst_t inst);
+void _bits_write(computation_ptr computation, proof_t proof, FILE* stream);
+void computation_bits(proof_t proof, var_t src, int negate, long offset, int count, var_t* bits) {
+	int i;
+	assert(count > 0 && count <= BITS_MAX);
+	computation_bits_ptr self = (computation_bits_ptr)pbc_malloc(sizeof(computation_bits_t));
+	self->base.clear = &_bits_clear;
+	self->base.apply = &_bits_apply;
+	self->base.write = &_bits_write;
+	self->base.kind = COMPUTATION_BITS;
+	self->base.is_secret = 1;
+	self->base.num_inputs = 1;
+	self->base.inputs = &self->src;
+	self->base.num_outputs = count;
+	self->base.outputs = self->bits = (var_t*)pbc_malloc(sizeof(var_t) * count);
+	self->src = src;
+	self->negate = negate;
+	self->offset = offset;
+	for (i = 0; i < count; i++) self->bits[i] = bits[i];
+	computation_insert(proof, &self->base);
+}
+
+void _bits_clear(computation_ptr computation) {
+	computation_bits_ptr self = (computation_bits_ptr)computation;
+	pbc_free(self->bits);
+	pbc_free(self);
+}
+
+void _bits_apply(computation_ptr computation, proof_t proof, inst_t inst) {
+	computation_bits_ptr self = (computation_bits_ptr)computation;
+	int i;
+	element_t value; element_init(value, proof->Z_type->field);
+	element_t offset; element_init(offset, proof->Z_type->field);
+	element_set(value, inst_var_get(proof, inst, self->src));
+	if (self->negate) element_neg(value, value);
+	element_set_si(offset, self->offset);
+	element_add(value, value, offset);
+	mpz_t n; mpz_init(n);
+	element_to_mpz(n, value);
+	
+	// Values out of range are decomposed modulo 2 ^ count; the proof then fails to verify.
+	for (i = 0; i < self->base.num_outputs; i++) {
+		element_set_si(value, mpz_tstbit(n, i));
+		inst_var_assign(proof, inst, self->bits[i], value);
+	}
+	mpz_clear(n);
+	element_clear(offset);
+	element_clear(value);
+}
+
+void _bits_write(computation_ptr computation, proof_t proof, FILE* stream) {
+	computation_bits_ptr self = (computation_bits_ptr)computation;
+	int i;
+	u64_write(self->src, stream);
+	u64_write(self->negate, stream);
+	u64_write((uint64_t)self->offset, stream);
+	u64_write(self->base.num_outputs, stream);
+	for (i = 0; i < self->base.num_outputs; i++) u64_write(self->bits[i], stream);
+}
+
+int _bits_read(proof_t proof, FILE* stream) {
+	int i;
+	var_t src; uint64_t negate, offset, count;
+	if (u64_read(&src, stream) != 8 || !var_valid(proof, src)) return 0;
+	if (u64_read(&negate, stream) != 8 || negate > 1) return 0;
+	if (u64_read(&offset, stream) != 8) return 0;
+	if (u64_read(&count, stream) != 8 || count == 0 || count > BITS_MAX) return 0;
+	var_t bits[BITS_MAX];
+	for (i = 0; i < (int)count; i++) {
+		if (u64_read(&bits[i], stream) != 8 || !var_valid(proof, bits[i]) || !var_is_secret(bits[i])) return 0;
+	}
+	computation_bits(proof, src, (int)negate, (long)offset, (int)count, bits);
+	return 1;
 }
@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include <pbc.h>
 #include "zkp_io.h"
 
@@ -24,17 +25,131 @@ size_t element_read(field_ptr field, element_t element, FILE* stream) {
 	return len;
 }
 
+size_t u64_write(uint64_t value, FILE* stream) {
+	int i; unsigned char data[8];
+	for (i = 0; i < 8; i++) data[i] = value >> (56 - 8 * i);
+	return fwrite(data, 1, 8, stream);
+}
+
+size_t u64_read(uint64_t* value, FILE* stream) {
+	int i; unsigned char data[8];
+	size_t len = fread(data, 1, 8, stream);
+	*value = 0;
+	for (i = 0; i < 8; i++) *value = (*value << 8) | data[i];
+	return len;
+}
+
+size_t u64_read_bytes(uint64_t* value, const unsigned char* bytes, size_t size) {
+	int i;
+	if (size < 8) return READ_INCOMPLETE;
+	*value = 0;
+	for (i = 0; i < 8; i++) *value = (*value << 8) | bytes[i];
+	return 8;
+}
+
+uint64_t hash_bytes(const unsigned char* bytes, size_t size) {
+	size_t i; uint64_t hash = 0xcbf29ce484222325ULL;
+	for (i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// Processes one 64-byte block of input.
+void _sha256_block(sha256_t ctx, const unsigned char* block) {
+	int i; uint32_t w[64];
+	for (i = 0; i < 16; i++) {
+		w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+			((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+	}
+	for (i = 16; i < 64; i++) {
+		uint32_t s0 = SHA256_ROTR(w[i - 15], 7) ^ SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		uint32_t s1 = SHA256_ROTR(w[i - 2], 17) ^ SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+	uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+	uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+	for (i = 0; i < 64; i++) {
+		uint32_t t1 = h + (SHA256_ROTR(e, 6) ^ SHA256_ROTR(e, 11) ^ SHA256_ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+		uint32_t t2 = (SHA256_ROTR(a, 2) ^ SHA256_ROTR(a, 13) ^ SHA256_ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+	ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+	ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+void sha256_init(sha256_t ctx) {
+	static const uint32_t initial[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	int i;
+	for (i = 0; i < 8; i++) ctx->state[i] = initial[i];
+	ctx->length = 0;
+	ctx->used = 0;
+}
+
+void sha256_update(sha256_t ctx, const unsigned char* bytes, size_t size) {
+	ctx->length += size;
+	while (size > 0) {
+		size_t part = 64 - ctx->used < size ? 64 - ctx->used : size;
+		memcpy(ctx->block + ctx->used, bytes, part);
+		ctx->used += part;
+		bytes += part;
+		size -= part;
+		if (ctx->used == 64) {
+			_sha256_block(ctx, ctx->block);
+			ctx->used = 0;
+		}
+	}
+}
+
+void sha256_final(sha256_t ctx, unsigned char digest[32]) {
+	int i;
+	uint64_t bits = ctx->length * 8;
+	unsigned char pad[72] = { 0x80 };
+	size_t pad_size = (ctx->used < 56 ? 56 : 120) - ctx->used;
+	for (i = 0; i < 8; i++) pad[pad_size + i] = bits >> (56 - 8 * i);
+	sha256_update(ctx, pad, pad_size + 8);
+	for (i = 0; i < 32; i++) digest[i] = ctx->state[i / 4] >> (24 - 8 * (i % 4));
+}
+
+size_t element_read_bytes(field_ptr field, element_t element, const unsigned char* bytes, size_t size) {
+	if (size < 4) return READ_INCOMPLETE;
+	uint32_t element_size = (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | (bytes[3] << 0);
+	if (element_size != element_length_in_bytes(element)) return READ_ERROR;
+	if (size - 4 < element_size) return READ_INCOMPLETE;
+	element_from_bytes(element, (unsigned char*)bytes + 4);
+	return 4 + element_size;
+}
+
 void _void_init(type_ptr type, data_ptr data) { }
 void _void_clear(type_ptr type, data_ptr data) { }
 void _void_copy(type_ptr type, data_ptr dest, data_ptr src) { }
 void _void_write(type_ptr type, data_ptr data, FILE* stream) { }
 void _void_read(type_ptr type, data_ptr data, FILE* stream) { }
+size_t _void_read_bytes(type_ptr type, data_ptr data, const unsigned char* bytes, size_t size) { return 0; }
 type_t void_type = {{
 	&_void_init,
 	&_void_clear,
 	&_void_copy,
 	&_void_write,
 	&_void_read,
+	&_void_read_bytes,
 	0
 }};
 	
@@ -43,12 +158,14 @@ void _element_clear(type_ptr, data_ptr);
 void _element_copy(type_ptr, data_ptr, data_ptr);
 void _element_write(type_ptr, data_ptr, FILE*);
 void _element_read(type_ptr, data_ptr, FILE*);
+size_t _element_read_bytes(type_ptr, data_ptr, const unsigned char*, size_t);
 void element_type_init(element_type_t type, field_ptr field) {
 	type->base->init = &_element_init;
 	type->base->clear = &_element_clear;
 	type->base->copy = &_element_copy;
 	type->base->write = &_element_write;
 	type->base->read = &_element_read;
+	type->base->read_bytes = &_element_read_bytes;
 	type->base->size = sizeof(element_t);
 	type->field = field;
 }
@@ -73,18 +190,24 @@ void _element_read(type_ptr type, data_ptr data, FILE* stream) {
 	element_read(((element_type_ptr)type)->field, (element_ptr)data, stream);
 }
 
+size_t _element_read_bytes(type_ptr type, data_ptr data, const unsigned char* bytes, size_t size) {
+	return element_read_bytes(((element_type_ptr)type)->field, (element_ptr)data, bytes, size);
+}
+
 
 void _array_init(type_ptr, data_ptr);
 void _array_clear(type_ptr, data_ptr);
 void _array_copy(type_ptr, data_ptr, data_ptr);
 void _array_write(type_ptr, data_ptr, FILE*);
 void _array_read(type_ptr, data_ptr, FILE*);
+size_t _array_read_bytes(type_ptr, data_ptr, const unsigned char*, size_t);
 void array_type_init(array_type_t type, type_ptr item_type, int count) {
 	type->base->init = &_array_init;
 	type->base->clear = &_array_clear;
 	type->base->copy = &_array_copy;
 	type->base->write = &_array_write;
 	type->base->read = &_array_read;
+	type->base->read_bytes = &_array_read_bytes;
 	type->base->size = count * item_type->size;
 	type->item_type = item_type;
 	type->count = count;
@@ -123,18 +246,32 @@ void _array_read(type_ptr type, data_ptr data, FILE* stream) {
 	for (i = 0; i < count; i++) read(item_type, (data_ptr)((char*)data + i * item_type->size), stream);
 }
 
+size_t _array_read_bytes(type_ptr type, data_ptr data, const unsigned char* bytes, size_t size) {
+	int i; int count = ((array_type_ptr)type)->count;
+	type_ptr item_type = ((array_type_ptr)type)->item_type;
+	size_t len = 0;
+	for (i = 0; i < count; i++) {
+		size_t item_len = read_bytes(item_type, (data_ptr)((char*)data + i * item_type->size), bytes + len, size - len);
+		if (read_failed(item_len)) return item_len;
+		len += item_len;
+	}
+	return len;
+}
+
 
 void _composite_init(type_ptr, data_ptr);
 void _composite_clear(type_ptr, data_ptr);
 void _composite_copy(type_ptr, data_ptr, data_ptr);
 void _composite_write(type_ptr, data_ptr, FILE*);
 void _composite_read(type_ptr, data_ptr, FILE*);
+size_t _composite_read_bytes(type_ptr, data_ptr, const unsigned char*, size_t);
 void composite_type_init_base(composite_type_t type, int count) {
 	type->base->init = &_composite_init;
 	type->base->clear = &_composite_clear;
 	type->base->copy = &_composite_copy;
 	type->base->write = &_composite_write;
 	type->base->read = &_composite_read;
+	type->base->read_bytes = &_composite_read_bytes;
 	type->part_types = (type_ptr*)pbc_malloc(sizeof(type_ptr) * count);
 	type->part_offsets = (size_t*)pbc_malloc(sizeof(size_t) * count);
 	type->count = count;
@@ -205,5 +342,14 @@ void _composite_read(type_ptr type, data_ptr data, FILE* stream) {
 	for (i = 0; i < count; i++) read(self->part_types[i], (data_ptr)((char*)data + self->part_offsets[i]), stream);
 }
 
-
-
+size_t _composite_read_bytes(type_ptr type, data_ptr data, const unsigned char* bytes, size_t size) {
+	composite_type_ptr self = ((composite_type_ptr)type);
+	int i; int count = self->count;
+	size_t len = 0;
+	for (i = 0; i < count; i++) {
+		size_t part_len = read_bytes(self->part_types[i], (data_ptr)((char*)data + self->part_offsets[i]), bytes + len, size - len);
+		if (read_failed(part_len)) return part_len;
+		len += part_len;
+	}
+	return len;
+}
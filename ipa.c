@@ -0,0 +1,679 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_internal.h"
+
+/***************************************************
+* ipa
+*
+* Verifies that a secret variable is the inner product
+* of two vectors of secret variables, with a claim and
+* response whose size is logarithmic in the length of
+* the vectors (a Bulletproofs inner-product argument).
+* The vectors may also be vectors of the proof, which
+* are used through their commitments, or one may be a
+* vector of public coefficients.
+****************************************************/
+
+typedef struct block_ipa_s *block_ipa_ptr;
+typedef struct block_ipa_s {
+	block_t base;
+	array_type_t Zr_type;
+	array_type_t claim_public_type;
+	composite_type_t claim_secret_type;
+	array_type_t Gx_type;
+	array_type_t Zx_type;
+	composite_type_t response_type;
+	int count;
+	int size;
+	int rounds;
+	int num_claim;
+	long product_index;
+	long *x_indices;
+	long *y_indices;
+	long x_vector;
+	long y_vector;
+	element_t *coefficients;
+	element_t *generators;
+	element_t *G;
+	element_t *H;
+} block_ipa_t[1];
+
+// e    	= challenge
+// n    	= count, padded up to size = 2 ^ rounds with zero values
+// G_#, H_#, u	= generators (derived by hashing, so that no relation between them is known)
+// z, o_z, C_z	= value, opening and commitment of product_index
+// x_#, o_x_#, C_x_#	= value, opening and commitment of x_indices[#]
+// y_#, o_y_#, C_y_#	= value, opening and commitment of y_indices[#]
+
+// The prover commits to the vectors, and to random vectors s_L and s_R that blind them:
+// [(r_a, r_b, s_L, s_R)]	= (h ^ r_a * G ^ x * H ^ y, h ^ r_b * G ^ s_L * H ^ s_R)	= (A, S)
+
+// Every later challenge is derived by hashing e with everything sent so far (Fiat-Shamir):
+// w, v and c from A and S; X from T_1 and T_2; k from t, t_o and m; and one for each round.
+// With r_# = w ^ #, q_# = v ^ #, a = x + c * q and b = y + c * r:
+// 	<a, b> = z + c * (<x, r> + <q, y>) + c ^ 2 * <q, r>
+// whose commitment C_t = C_z * (prod C_x_# ^ r_# * C_y_# ^ q_#) ^ c * g ^ (c ^ 2 * <q, r>) is
+// known to the verifier. Since r and q are chosen after A is fixed, this ties the vectors
+// in A to the committed variables, with negligible probability of error.
+
+// With l = a + s_L * X and p = b + s_R * X, <l, p> = t_0 + t_1 * X + t_2 * X ^ 2, and the
+// prover sends T_1 = g ^ t_1 * h ^ o_1, T_2 = g ^ t_2 * h ^ o_2, then t = <l, p>,
+// t_o = o_t + o_1 * X + o_2 * X ^ 2 and m = r_a + r_b * X, and finally shows that
+// A * S ^ X * h ^ -m * G ^ (c * q) * H ^ (c * r) = G ^ l * H ^ p with <l, p> = t by halving
+// the vectors once per round, sending L and R each time, down to single values l and p.
+
+// The verifier checks g ^ t * h ^ t_o = C_t * T_1 ^ X * T_2 ^ (X ^ 2), and the halving
+// through a single equation with exponents s_# = prod x_j ^ (+/- 1) for each generator,
+// both combined with a random weight into one multi-exponentiation.
+
+// [(r_a, r_b, s_L, s_R), (A, S)]	= (A, S)
+// [x, y, z, o]     	= ([T_1, T_2, L ..., R ...], [t, t_o, m, l, p])
+
+// For vectors of the proof, the vector commitments take the place of A, and nothing need
+// tie them to other commitments, so c = 0:
+// G_#, H_#	= generators of the x and y vectors
+// A	= V_x * V_y	(with r_a = o_V_x + o_V_y)
+// For a vector and public coefficients y_#, with H_# derived by hashing as above:
+// A	= V_x * H ^ y	(with r_a = o_V_x)
+// [(r_a, r_b, s_L, s_R), S]	= S
+
+void _ipa_clear(block_ptr);
+int _ipa_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _ipa_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
+void _ipa_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _ipa_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+block_ipa_ptr block_ipa_base(proof_t proof, int kind, int count, long x_vector, long y_vector) {
+	int i; int size = 1; int rounds = 0;
+	while (size < count) {
+		size *= 2;
+		rounds++;
+	}
+	block_ipa_ptr self = (block_ipa_ptr)pbc_malloc(sizeof(block_ipa_t));
+	self->num_claim = kind == BLOCK_IPA ? 2 : 1;
+	array_type_init(self->Zr_type, (type_ptr)proof->Z_type, 2 * size + 2);
+	array_type_init(self->claim_public_type, (type_ptr)proof->G_type, self->num_claim);
+	composite_type_init(self->claim_secret_type, 2, (type_ptr)self->Zr_type, (type_ptr)self->claim_public_type);
+	array_type_init(self->Gx_type, (type_ptr)proof->G_type, 2 * rounds + 2);
+	array_type_init(self->Zx_type, (type_ptr)proof->Z_type, 5);
+	composite_type_init(self->response_type, 2, (type_ptr)self->Gx_type, (type_ptr)self->Zx_type);
+	self->base->clear = &_ipa_clear;
+	self->base->write = &_ipa_write;
+	self->base->codegen = NULL;
+	self->base->claim_gen = &_ipa_claim_gen;
+	self->base->response_gen = &_ipa_response_gen;
+	self->base->response_verify = &_ipa_response_verify;
+	self->base->response_verify_batch = NULL;
+	self->base->response_verify_step = NULL;
+	self->base->verify_steps = 1;
+	self->base->supplement_type = (type_ptr)void_type;
+	self->base->claim_secret_type = (type_ptr)self->claim_secret_type;
+	self->base->claim_public_type = (type_ptr)self->claim_public_type;
+	self->base->response_type = (type_ptr)self->response_type;
+	self->base->kind = kind;
+	self->count = count;
+	self->size = size;
+	self->rounds = rounds;
+	self->x_indices = (long*)pbc_malloc(sizeof(long) * count);
+	self->y_indices = (long*)pbc_malloc(sizeof(long) * count);
+	self->x_vector = x_vector;
+	self->y_vector = y_vector;
+	self->coefficients = NULL;
+	if (kind == BLOCK_VECTOR_LINEAR) {
+		self->coefficients = (element_t*)pbc_malloc(sizeof(element_t) * count);
+		for (i = 0; i < count; i++) element_init(self->coefficients[i], proof->Z_type->field);
+	}
+
+	// Only the generators that no vector provides are derived.
+	self->generators = (element_t*)pbc_malloc(sizeof(element_t) * (2 * size + 1));
+	for (i = 0; i < 2 * size + 1; i++) element_init(self->generators[i], proof->G_type->field);
+	for (i = 0; i < size; i++) {
+		if (x_vector < 0) element_from_label(self->generators[i], "zkp ipa G", i);
+		if (y_vector < 0) element_from_label(self->generators[size + i], "zkp ipa H", i);
+	}
+	element_from_label(self->generators[2 * size], "zkp ipa u", 0);
+	self->G = x_vector < 0 ? self->generators : proof->vectors[x_vector].generators;
+	self->H = y_vector < 0 ? self->generators + size : proof->vectors[y_vector].generators;
+	for (i = 0; i < count; i++) {
+		if (x_vector >= 0) self->x_indices[i] = proof->vectors[x_vector].first + i;
+		if (y_vector >= 0) self->y_indices[i] = proof->vectors[y_vector].first + i;
+	}
+	block_insert(proof, (block_ptr)self);
+	return self;
+}
+
+void _ipa_clear(block_ptr block) {
+	block_ipa_ptr self = (block_ipa_ptr)block;
+	int i;
+	for (i = 0; i < 2 * self->size + 1; i++) element_clear(self->generators[i]);
+	if (self->coefficients != NULL) {
+		for (i = 0; i < self->count; i++) element_clear(self->coefficients[i]);
+		pbc_free(self->coefficients);
+	}
+	composite_type_clear(self->claim_secret_type);
+	composite_type_clear(self->response_type);
+	pbc_free(self->generators);
+	pbc_free(self->x_indices);
+	pbc_free(self->y_indices);
+	pbc_free(self);
+}
+
+int _ipa_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_ipa_ptr self = (block_ipa_ptr)block;
+	int i;
+	switch (block->kind) {
+		case BLOCK_IPA:
+			u64_write(self->count, stream);
+			u64_write(self->product_index, stream);
+			for (i = 0; i < self->count; i++) {
+				u64_write(self->x_indices[i], stream);
+				u64_write(self->y_indices[i], stream);
+			}
+			break;
+		case BLOCK_VECTOR_INNER_PRODUCT:
+			u64_write(self->product_index, stream);
+			u64_write(self->x_vector, stream);
+			u64_write(self->y_vector, stream);
+			break;
+		case BLOCK_VECTOR_LINEAR:
+			u64_write(self->product_index, stream);
+			u64_write(self->x_vector, stream);
+			for (i = 0; i < self->count; i++) element_write(proof->Z_type->field, self->coefficients[i], stream);
+			break;
+	}
+	return 1;
+}
+
+int block_ipa_read(proof_t proof, FILE* stream) {
+	int i; uint64_t count;
+	if (u64_read(&count, stream) != 8 || count == 0 || count > INT_MAX / 8) return 0;
+	block_ipa_ptr self = block_ipa_base(proof, BLOCK_IPA, (int)count, -1, -1);
+	if (!secret_index_read(proof, &self->product_index, stream)) return 0;
+	for (i = 0; i < (int)count; i++) {
+		if (!secret_index_read(proof, &self->x_indices[i], stream)) return 0;
+		if (!secret_index_read(proof, &self->y_indices[i], stream)) return 0;
+	}
+	return 1;
+}
+
+int block_vector_inner_product_read(proof_t proof, FILE* stream) {
+	long product_index, x_vector, y_vector;
+	if (!secret_index_read(proof, &product_index, stream)) return 0;
+	if (!index_read(&x_vector, proof->num_vectors, stream)) return 0;
+	if (!index_read(&y_vector, proof->num_vectors, stream)) return 0;
+	if (x_vector == y_vector || proof->vectors[x_vector].count != proof->vectors[y_vector].count) return 0;
+	block_ipa_ptr self = block_ipa_base(proof, BLOCK_VECTOR_INNER_PRODUCT, proof->vectors[x_vector].count, x_vector, y_vector);
+	self->product_index = product_index;
+	return 1;
+}
+
+int block_vector_linear_read(proof_t proof, FILE* stream) {
+	int i; long product_index, x_vector;
+	if (!secret_index_read(proof, &product_index, stream)) return 0;
+	if (!index_read(&x_vector, proof->num_vectors, stream)) return 0;
+	block_ipa_ptr self = block_ipa_base(proof, BLOCK_VECTOR_LINEAR, proof->vectors[x_vector].count, x_vector, -1);
+	self->product_index = product_index;
+	for (i = 0; i < self->count; i++) {
+		if (!element_read(proof->Z_type->field, self->coefficients[i], stream)) return 0;
+	}
+	return 1;
+}
+
+// Adds an element to a transcript.
+void _ipa_absorb(sha256_t ctx, element_t element) {
+	int size = element_length_in_bytes(element);
+	unsigned char *bytes = (unsigned char*)pbc_malloc(size);
+	element_to_bytes(bytes, element);
+	sha256_update(ctx, bytes, size);
+	pbc_free(bytes);
+}
+
+// Derives a challenge from a transcript, leaving the transcript unchanged. Challenges
+// derived from the same transcript are distinguished by their tags.
+void _ipa_challenge(element_t out, sha256_t ctx, unsigned char tag) {
+	unsigned char digest[32];
+	sha256_t copy; *copy = *ctx;
+	sha256_update(copy, &tag, 1);
+	sha256_final(copy, digest);
+	element_from_hash(out, digest, 32);
+}
+
+// Sets out[#] = base ^ # for # < count.
+void _ipa_powers(element_t* out, element_t base, int count) {
+	int i;
+	if (count > 0) element_set1(out[0]);
+	for (i = 1; i < count; i++) element_mul(out[i], out[i - 1], base);
+}
+
+// Computes the inner product of two vectors of the given length.
+void _ipa_dot(element_t out, element_t* a, element_t* b, int count, element_t term) {
+	int i;
+	element_set0(out);
+	for (i = 0; i < count; i++) {
+		element_mul(term, a[i], b[i]);
+		element_add(out, out, term);
+	}
+}
+
+// Allocates and initializes an array of elements in the given field.
+element_t* _ipa_new(field_ptr field, int count) {
+	int i;
+	element_t *elements = (element_t*)pbc_malloc(sizeof(element_t) * count);
+	for (i = 0; i < count; i++) element_init(elements[i], field);
+	return elements;
+}
+
+// Clears and frees an array of elements.
+void _ipa_free(element_t* elements, int count) {
+	int i;
+	for (i = 0; i < count; i++) element_clear(elements[i]);
+	pbc_free(elements);
+}
+
+void _ipa_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
+	block_ipa_ptr self = (block_ipa_ptr)block;
+	int i; int count = self->count; int size = self->size;
+	element_t *r = (element_t*)get_part(self->claim_secret_type, claim_secret, 0);
+	element_t *copies = (element_t*)get_part(self->claim_secret_type, claim_secret, 1);
+	element_t *G = self->G;
+	element_t *H = self->H;
+	element_ptr A = get_element(proof->G_type, get_item(self->claim_public_type, claim_public, 0));
+	element_ptr S = get_element(proof->G_type, get_item(self->claim_public_type, claim_public, self->num_claim - 1));
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (2 * size + 1));
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (2 * size + 1));
+	for (i = 0; i < 2 * size + 2; i++) element_random(r[i]);
+
+	// A = h ^ r_a * G ^ x * H ^ y, unless the vector commitments stand in for it
+	if (self->num_claim == 2) {
+		for (i = 0; i < count; i++) {
+			bases[i] = G[i];
+			exps[i] = inst->secret_values[self->x_indices[i]];
+			bases[count + i] = H[i];
+			exps[count + i] = inst->secret_values[self->y_indices[i]];
+		}
+		bases[2 * count] = proof->h;
+		exps[2 * count] = r[0];
+		element_multi_pow(A, 2 * count + 1, bases, exps);
+	}
+
+	// S = h ^ r_b * G ^ s_L * H ^ s_R
+	for (i = 0; i < size; i++) {
+		bases[i] = G[i];
+		exps[i] = r[2 + i];
+		bases[size + i] = H[i];
+		exps[size + i] = r[2 + size + i];
+	}
+	bases[2 * size] = proof->h;
+	exps[2 * size] = r[1];
+	element_multi_pow(S, 2 * size + 1, bases, exps);
+
+	// The prover needs the claim again to derive the challenges.
+	for (i = 0; i < self->num_claim; i++) {
+		element_set(copies[i], get_element(proof->G_type, get_item(self->claim_public_type, claim_public, i)));
+	}
+	pbc_free(bases);
+	pbc_free(exps);
+}
+
+// Starts the transcript for an instance of the block and derives w, v and c from it.
+void _ipa_start(block_ipa_ptr self, sha256_t ctx, element_t* claim_public, challenge_t challenge, element_t w, element_t v, element_t c) {
+	int i;
+	sha256_init(ctx);
+	_ipa_absorb(ctx, challenge);
+	for (i = 0; i < self->num_claim; i++) _ipa_absorb(ctx, claim_public[i]);
+	_ipa_challenge(w, ctx, 0);
+	_ipa_challenge(v, ctx, 1);
+	_ipa_challenge(c, ctx, 2);
+	if (self->num_claim == 1) element_set0(c);
+}
+
+void _ipa_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response) {
+	block_ipa_ptr self = (block_ipa_ptr)block;
+	int i, j; int count = self->count; int size = self->size; int rounds = self->rounds;
+	int links = self->num_claim == 2 ? count : 0;
+	field_ptr Z = proof->Z_type->field;
+	field_ptr G_field = proof->G_type->field;
+	element_t *r = (element_t*)get_part(self->claim_secret_type, claim_secret, 0);
+	element_t *s_L = r + 2;
+	element_t *s_R = r + 2 + size;
+	element_t *Gx = (element_t*)get_part(self->response_type, response, 0);
+	element_t *Zx = (element_t*)get_part(self->response_type, response, 1);
+	element_ptr T_1 = Gx[0], T_2 = Gx[1];
+	element_ptr t = Zx[0], t_o = Zx[1], m = Zx[2];
+	element_ptr term = inst->scratch_Z[0];
+
+	element_t w, v, c, X, k, x, x_inv, o_1, o_2, t_1, t_2, c_L, c_R;
+	element_t *scalars[] = { &w, &v, &c, &X, &k, &x, &x_inv, &o_1, &o_2, &t_1, &t_2, &c_L, &c_R };
+	for (i = 0; i < (int)(sizeof(scalars) / sizeof(*scalars)); i++) element_init(*scalars[i], Z);
+	element_t *q = _ipa_new(Z, size);
+	element_t *l = _ipa_new(Z, size);
+	element_t *p = _ipa_new(Z, size);
+	sha256_t ctx;
+	_ipa_start(self, ctx, (element_t*)get_part(self->claim_secret_type, claim_secret, 1), challenge, w, v, c);
+
+	// a = x + c * q, b = y + c * r
+	_ipa_powers(q, v, size);
+	_ipa_powers(p, w, size);
+	for (i = 0; i < size; i++) {
+		element_mul(l[i], c, q[i]);
+		element_mul(p[i], c, p[i]);
+		if (i < count) {
+			element_add(l[i], l[i], inst->secret_values[self->x_indices[i]]);
+			element_add(p[i], p[i], self->coefficients != NULL ? self->coefficients[i] : inst->secret_values[self->y_indices[i]]);
+		}
+	}
+
+	// T_1 = g ^ (<a, s_R> + <s_L, b>) * h ^ o_1, T_2 = g ^ <s_L, s_R> * h ^ o_2
+	_ipa_dot(t_1, l, s_R, size, term);
+	_ipa_dot(t_2, s_L, p, size, term);
+	element_add(t_1, t_1, t_2);
+	_ipa_dot(t_2, s_L, s_R, size, term);
+	element_random(o_1);
+	element_random(o_2);
+	proof_pow_gh(proof, T_1, t_1, o_1);
+	proof_pow_gh(proof, T_2, t_2, o_2);
+	_ipa_absorb(ctx, T_1);
+	_ipa_absorb(ctx, T_2);
+	_ipa_challenge(X, ctx, 3);
+
+	// l = a + s_L * X, p = b + s_R * X, t = <l, p>
+	for (i = 0; i < size; i++) {
+		element_mul(term, s_L[i], X);
+		element_add(l[i], l[i], term);
+		element_mul(term, s_R[i], X);
+		element_add(p[i], p[i], term);
+	}
+	_ipa_dot(t, l, p, size, term);
+
+	// t_o = o_z + c * (sum r_# * o_x_# + q_# * o_y_#) + o_1 * X + o_2 * X ^ 2
+	element_set1(x);
+	element_set0(t_o);
+	for (i = 0; i < links; i++) {
+		element_mul(term, x, inst->secret_openings[self->x_indices[i]]);
+		element_add(t_o, t_o, term);
+		element_mul(term, q[i], inst->secret_openings[self->y_indices[i]]);
+		element_add(t_o, t_o, term);
+		element_mul(x, x, w);
+	}
+	element_mul(t_o, t_o, c);
+	element_add(t_o, t_o, inst->secret_openings[self->product_index]);
+	element_mul(term, o_2, X);
+	element_add(term, term, o_1);
+	element_mul(term, term, X);
+	element_add(t_o, t_o, term);
+
+	// m = r_a + r_b * X
+	element_mul(m, r[1], X);
+	if (self->num_claim == 2) element_add(m, m, r[0]);
+	if (self->x_vector >= 0) element_add(m, m, inst->secret_openings[proof->vectors[self->x_vector].first]);
+	if (self->y_vector >= 0) element_add(m, m, inst->secret_openings[proof->vectors[self->y_vector].first]);
+	_ipa_absorb(ctx, t);
+	_ipa_absorb(ctx, t_o);
+	_ipa_absorb(ctx, m);
+	_ipa_challenge(k, ctx, 4);
+
+	// Halve l and p, with generators G, H and u ^ k, once per round.
+	element_t *G = _ipa_new(G_field, size);
+	element_t *H = _ipa_new(G_field, size);
+	element_t u; element_init(u, G_field);
+	for (i = 0; i < size; i++) {
+		element_set(G[i], self->G[i]);
+		element_set(H[i], self->H[i]);
+	}
+	element_pow_zn(u, self->generators[2 * size], k);
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (size + 1));
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (size + 1));
+	int half = size;
+	for (j = 0; j < rounds; j++) {
+		element_ptr L = Gx[2 + j];
+		element_ptr R = Gx[2 + rounds + j];
+		half /= 2;
+
+		// L = G_hi ^ l_lo * H_lo ^ p_hi * u ^ <l_lo, p_hi>
+		_ipa_dot(c_L, l, p + half, half, term);
+		for (i = 0; i < half; i++) {
+			bases[i] = G[half + i];
+			exps[i] = l[i];
+			bases[half + i] = H[i];
+			exps[half + i] = p[half + i];
+		}
+		bases[2 * half] = u;
+		exps[2 * half] = c_L;
+		element_multi_pow(L, 2 * half + 1, bases, exps);
+
+		// R = G_lo ^ l_hi * H_hi ^ p_lo * u ^ <l_hi, p_lo>
+		_ipa_dot(c_R, l + half, p, half, term);
+		for (i = 0; i < half; i++) {
+			bases[i] = G[i];
+			exps[i] = l[half + i];
+			bases[half + i] = H[half + i];
+			exps[half + i] = p[i];
+		}
+		bases[2 * half] = u;
+		exps[2 * half] = c_R;
+		element_multi_pow(R, 2 * half + 1, bases, exps);
+
+		_ipa_absorb(ctx, L);
+		_ipa_absorb(ctx, R);
+		_ipa_challenge(x, ctx, 5);
+		element_invert(x_inv, x);
+
+		// G = G_lo ^ x_inv * G_hi ^ x, H = H_lo ^ x * H_hi ^ x_inv,
+		// l = l_lo * x + l_hi * x_inv, p = p_lo * x_inv + p_hi * x
+		for (i = 0; i < half; i++) {
+			element_pow2_zn(G[i], G[i], x_inv, G[half + i], x);
+			element_pow2_zn(H[i], H[i], x, H[half + i], x_inv);
+			element_mul(l[i], l[i], x);
+			element_mul(term, l[half + i], x_inv);
+			element_add(l[i], l[i], term);
+			element_mul(p[i], p[i], x_inv);
+			element_mul(term, p[half + i], x);
+			element_add(p[i], p[i], term);
+		}
+	}
+	element_set(Zx[3], l[0]);
+	element_set(Zx[4], p[0]);
+
+	for (i = 0; i < (int)(sizeof(scalars) / sizeof(*scalars)); i++) element_clear(*scalars[i]);
+	_ipa_free(q, size);
+	_ipa_free(l, size);
+	_ipa_free(p, size);
+	_ipa_free(G, size);
+	_ipa_free(H, size);
+	element_clear(u);
+	pbc_free(bases);
+	pbc_free(exps);
+}
+
+int _ipa_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	block_ipa_ptr self = (block_ipa_ptr)block;
+	int i, j; int count = self->count; int size = self->size; int rounds = self->rounds;
+	int links = self->num_claim == 2 ? count : 0;
+	field_ptr Z = proof->Z_type->field;
+	element_t *Gx = (element_t*)get_part(self->response_type, response, 0);
+	element_t *Zx = (element_t*)get_part(self->response_type, response, 1);
+	element_ptr T_1 = Gx[0], T_2 = Gx[1];
+	element_ptr t = Zx[0], t_o = Zx[1], m = Zx[2], l = Zx[3], p = Zx[4];
+	element_ptr term = inst->scratch_Z[0];
+
+	element_t w, v, c, X, k, weight, c_weight, q_r;
+	element_t *scalars[] = { &w, &v, &c, &X, &k, &weight, &c_weight, &q_r };
+	for (i = 0; i < (int)(sizeof(scalars) / sizeof(*scalars)); i++) element_init(*scalars[i], Z);
+	sha256_t ctx;
+	_ipa_start(self, ctx, (element_t*)claim_public, challenge, w, v, c);
+	_ipa_absorb(ctx, T_1);
+	_ipa_absorb(ctx, T_2);
+	_ipa_challenge(X, ctx, 3);
+	_ipa_absorb(ctx, t);
+	_ipa_absorb(ctx, t_o);
+	_ipa_absorb(ctx, m);
+	_ipa_challenge(k, ctx, 4);
+
+	// The round challenges x_j, and their squares and inverse squares.
+	element_t *x = _ipa_new(Z, rounds > 0 ? rounds : 1);
+	element_t *x_sq = _ipa_new(Z, 2 * rounds + 1);
+	element_t *x_inv_sq = x_sq + rounds;
+	for (j = 0; j < rounds; j++) {
+		_ipa_absorb(ctx, Gx[2 + j]);
+		_ipa_absorb(ctx, Gx[2 + rounds + j]);
+		_ipa_challenge(x[j], ctx, 5);
+		element_square(x_sq[j], x[j]);
+		element_invert(x_inv_sq[j], x_sq[j]);
+	}
+
+	// The exponents of every term: G (size), H (size), C_x (links), C_y (links), then A, S,
+	// u, g, h, C_z, T_1, T_2, L (rounds), R (rounds) and, for two vectors, V_y. Without
+	// links to other commitments, there are no C_x or C_y terms.
+	int fixed = 2 * size + 2 * links + 8;
+	int num_terms = fixed + 2 * rounds + (self->y_vector >= 0);
+	element_t *exps = _ipa_new(Z, fixed);
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * num_terms);
+	element_ptr *exp_ptrs = (element_ptr*)pbc_malloc(sizeof(element_ptr) * num_terms);
+	element_t *G_exps = exps;
+	element_t *H_exps = exps + size;
+	element_t *C_x_exps = exps + 2 * size;
+	element_t *C_y_exps = exps + 2 * size + links;
+	element_t *rest = exps + 2 * size + 2 * links;
+	element_ptr *rest_bases = bases + 2 * size + 2 * links;
+
+	// s_0 = prod x_j ^ -1, and s_# = s_(# with its lowest bit cleared) * x_j ^ 2 for the
+	// round j that the bit selects. G_exps holds s and H_exps holds 1 / s for now.
+	element_set1(G_exps[0]);
+	element_set1(H_exps[0]);
+	for (j = 0; j < rounds; j++) {
+		element_mul(H_exps[0], H_exps[0], x[j]);
+	}
+	element_invert(G_exps[0], H_exps[0]);
+	for (i = 1; i < size; i++) {
+		int bit = 0;
+		while (!((i >> bit) & 1)) bit++;
+		j = rounds - 1 - bit;
+		element_mul(G_exps[i], G_exps[i & (i - 1)], x_sq[j]);
+		element_mul(H_exps[i], H_exps[i & (i - 1)], x_inv_sq[j]);
+	}
+
+	// G_# ^ (c * q_# - l * s_#) and H_# ^ (c * r_# - p / s_#), with q_# = v ^ #, r_# = w ^ #,
+	// accumulating <q, r> on the way. Public coefficients add H ^ y.
+	element_random(weight);
+	element_mul(c_weight, c, weight);
+	element_neg(c_weight, c_weight);
+	element_t q_i; element_init(q_i, Z); element_set1(q_i);
+	element_t r_i; element_init(r_i, Z); element_set1(r_i);
+	element_set0(q_r);
+	for (i = 0; i < size; i++) {
+		element_mul(G_exps[i], G_exps[i], l);
+		element_mul(term, c, q_i);
+		element_sub(G_exps[i], term, G_exps[i]);
+		element_mul(H_exps[i], H_exps[i], p);
+		element_mul(term, c, r_i);
+		element_sub(H_exps[i], term, H_exps[i]);
+		if (self->coefficients != NULL && i < count) {
+			element_add(H_exps[i], H_exps[i], self->coefficients[i]);
+		}
+		if (i < links) {
+
+			// C_x_# ^ -(weight * c * r_#) and C_y_# ^ -(weight * c * q_#)
+			element_mul(C_x_exps[i], c_weight, r_i);
+			element_mul(C_y_exps[i], c_weight, q_i);
+			bases[2 * size + i] = inst->secret_commitments[self->x_indices[i]];
+			bases[2 * size + links + i] = inst->secret_commitments[self->y_indices[i]];
+		}
+		element_mul(term, q_i, r_i);
+		element_add(q_r, q_r, term);
+		element_mul(q_i, q_i, v);
+		element_mul(r_i, r_i, w);
+		bases[i] = self->G[i];
+		bases[size + i] = self->H[i];
+	}
+	element_clear(q_i);
+	element_clear(r_i);
+
+	// A ^ 1 * S ^ X, with A the vector commitments V_x (and V_y, last) if there are any
+	element_set1(rest[0]);
+	if (self->x_vector >= 0) {
+		rest_bases[0] = inst->secret_commitments[proof->vectors[self->x_vector].first];
+	} else {
+		rest_bases[0] = get_element(proof->G_type, get_item(self->claim_public_type, claim_public, 0));
+	}
+	element_set(rest[1], X);
+	rest_bases[1] = get_element(proof->G_type, get_item(self->claim_public_type, claim_public, self->num_claim - 1));
+
+	// u ^ (k * (t - l * p))
+	element_mul(rest[2], l, p);
+	element_sub(rest[2], t, rest[2]);
+	element_mul(rest[2], rest[2], k);
+	rest_bases[2] = self->generators[2 * size];
+
+	// g ^ (weight * (t - c ^ 2 * <q, r>))
+	element_square(term, c);
+	element_mul(term, term, q_r);
+	element_sub(rest[3], t, term);
+	element_mul(rest[3], rest[3], weight);
+	rest_bases[3] = proof->g;
+
+	// h ^ (weight * t_o - m)
+	element_mul(rest[4], weight, t_o);
+	element_sub(rest[4], rest[4], m);
+	rest_bases[4] = proof->h;
+
+	// C_z ^ -weight * T_1 ^ -(weight * X) * T_2 ^ -(weight * X ^ 2)
+	element_neg(rest[5], weight);
+	rest_bases[5] = inst->secret_commitments[self->product_index];
+	element_mul(rest[6], rest[5], X);
+	rest_bases[6] = T_1;
+	element_mul(rest[7], rest[6], X);
+	rest_bases[7] = T_2;
+
+	for (i = 0; i < fixed; i++) exp_ptrs[i] = exps[i];
+
+	// L_j ^ (x_j ^ 2) * R_j ^ (x_j ^ -2)
+	for (j = 0; j < rounds; j++) {
+		bases[fixed + j] = Gx[2 + j];
+		exp_ptrs[fixed + j] = x_sq[j];
+		bases[fixed + rounds + j] = Gx[2 + rounds + j];
+		exp_ptrs[fixed + rounds + j] = x_inv_sq[j];
+	}
+	if (self->y_vector >= 0) {
+		bases[fixed + 2 * rounds] = inst->secret_commitments[proof->vectors[self->y_vector].first];
+		exp_ptrs[fixed + 2 * rounds] = rest[0];
+	}
+
+	element_ptr result = inst->scratch_G[0];
+	element_multi_pow(result, num_terms, bases, exp_ptrs);
+	int valid = element_is1(result);
+
+	for (i = 0; i < (int)(sizeof(scalars) / sizeof(*scalars)); i++) element_clear(*scalars[i]);
+	_ipa_free(x, rounds > 0 ? rounds : 1);
+	_ipa_free(x_sq, 2 * rounds + 1);
+	_ipa_free(exps, fixed);
+	pbc_free(bases);
+	pbc_free(exp_ptrs);
+	return valid;
+}
+
+void require_inner_product_log(proof_t proof, var_t product, int count, var_t* xs, var_t* ys) {
+	int i;
+	block_ipa_ptr self = block_ipa_base(proof, BLOCK_IPA, count, -1, -1);
+	self->product_index = var_secret_index(proof, product);
+	for (i = 0; i < count; i++) {
+		self->x_indices[i] = var_secret_index(proof, xs[i]);
+		self->y_indices[i] = var_secret_index(proof, ys[i]);
+	}
+}
+
+void require_vector_inner_product(proof_t proof, var_t product, vec_t xs, vec_t ys) {
+	assert(xs != ys && proof->vectors[xs].count == proof->vectors[ys].count);
+	block_ipa_ptr self = block_ipa_base(proof, BLOCK_VECTOR_INNER_PRODUCT, proof->vectors[xs].count, xs, ys);
+	self->product_index = var_secret_index(proof, product);
+}
+
+void require_vector_linear(proof_t proof, var_t sum, vec_t xs, element_t* coeffs) {
+	int i;
+	block_ipa_ptr self = block_ipa_base(proof, BLOCK_VECTOR_LINEAR, proof->vectors[xs].count, xs, -1);
+	self->product_index = var_secret_index(proof, sum);
+	for (i = 0; i < self->count; i++) element_set(self->coefficients[i], coeffs[i]);
+}
@@ -2,22 +2,37 @@
 #include "zkp.h"
 
 int main() {
-	pairing_t pairing;
-	
+	// Load pairing and commitment bases from the cache, creating it on the first run or
+	// when the parameters have changed.
 	FILE* fparam = fopen("a.param", "rb");
 	char param[1024];
 	size_t count = fread(param, 1, 1024, fparam);
 	fclose(fparam);
 	if (!count) pbc_die("input error");
-	pairing_init_set_buf(pairing, param, count);
-	
-	// Setup field.
-	element_t g;
-	element_t h;
-	element_init_G1(g, pairing);
-	element_init_G1(h, pairing);
-	element_random(g);
-	element_random(h);
+	cache_t cache;
+	if (!cache_open(cache, "a.cache", param, count)) {
+		pairing_t pairing;
+		pairing_init_set_buf(pairing, param, count);
+		
+		// Setup field.
+		element_t g;
+		element_t h;
+		element_init_G1(g, pairing);
+		element_init_G1(h, pairing);
+		element_random(g);
+		element_random(h);
+		
+		FILE* fcache = fopen("a.cache", "wb");
+		cache_write(fcache, param, count, g, h);
+		fclose(fcache);
+		element_clear(g);
+		element_clear(h);
+		pairing_clear(pairing);
+		if (!cache_open(cache, "a.cache", param, count)) pbc_die("cache error");
+	}
+	pairing_ptr pairing = cache->pairing;
+	element_ptr g = cache->g;
+	element_ptr h = cache->h;
 	
 	// Create a signature scheme
 	sig_scheme_t scheme;
@@ -29,6 +44,7 @@ int main() {
 	// Describe proof (prover and verifier).
 	proof_t proof;
 	proof_init(proof, pairing->Zr, pairing->G1, g, h);
+	proof_set_tables(proof, cache->g_table, cache->h_table);
 	
 	supplement_t sig_supplement;
 	var_t p = var_secret(proof);
@@ -36,6 +52,7 @@ int main() {
 	var_t m = var_public(proof);
 	require_mul(proof, m, p, q);
 	require_sig(proof, scheme, public_key, &sig_supplement, p, q, m);
+	proof_finalize(proof);
 	
 	// Create a challenge (constant for demonstration purposes).
 	element_t challenge;
@@ -90,7 +107,7 @@ int main() {
 	inst_t vinst;
 	inst_init_verifier(proof, vinst);
 	inst_var_read(proof, vinst, m, vmessage);
-	inst_commitments_read(proof, vinst, vmessage);
+	if (!inst_commitments_read(proof, vinst, vmessage)) pbc_die("message error");
 	inst_update(proof, vinst);
 	
 	// Read witness (verifier)
@@ -109,5 +126,27 @@ int main() {
 	
 	getchar();
 	getchar();
+	
+	// Clean up, releasing the cache last since the proof uses its tables.
+	delete((type_ptr)&proof->claim_public_type, vclaim_public);
+	delete((type_ptr)&proof->response_type, vresponse);
+	delete((type_ptr)&proof->claim_secret_type, pclaim_secret);
+	delete((type_ptr)&proof->claim_public_type, pclaim_public);
+	delete((type_ptr)&proof->response_type, presponse);
+	inst_clear(proof, vinst);
+	inst_clear(proof, pinst);
+	mpz_clear(p_val);
+	mpz_clear(q_val);
+	mpz_clear(m_val);
+	delete((type_ptr)scheme->sig_type, sig);
+	element_clear(message[0]);
+	element_clear(message[1]);
+	element_clear(message[2]);
+	element_clear(challenge);
+	proof_clear(proof);
+	delete((type_ptr)scheme->secret_key_type, secret_key);
+	delete((type_ptr)scheme->public_key_type, public_key);
+	sig_scheme_clear(scheme);
+	cache_close(cache);
 	return 0;
 }
@@ -0,0 +1,158 @@
+#include <limits.h>
+#include <string.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_sig.h"
+#include "zkp_proof.h"
+#include "zkp_member.h"
+
+// The number of values a set has room for when it is created.
+#define MEMBER_CAPACITY 16
+
+// Hashes the canonical encoding of a value.
+uint64_t _member_hash(element_t value) {
+	int size = element_length_in_bytes(value);
+	unsigned char *bytes = (unsigned char*)pbc_malloc(size);
+	element_to_bytes(bytes, value);
+	uint64_t hash = hash_bytes(bytes, size);
+	pbc_free(bytes);
+	return hash;
+}
+
+// Inserts the value at the given index into the hash table of a set.
+void _member_table_insert(member_set_t set, int index) {
+	size_t mask = set->table_size - 1;
+	size_t slot = _member_hash(set->values[index]) & mask;
+	while (set->table[slot] >= 0) slot = (slot + 1) & mask;
+	set->table[slot] = index;
+}
+
+// Rebuilds the hash table of a set with room for its capacity.
+void _member_table_build(member_set_t set) {
+	int i;
+	set->table_size = 1;
+	while (set->table_size < 2 * (size_t)set->capacity) set->table_size <<= 1;
+	if (set->table != NULL) pbc_free(set->table);
+	set->table = (int*)pbc_malloc(sizeof(int) * set->table_size);
+	memset(set->table, 0xff, sizeof(int) * set->table_size);
+	for (i = 0; i < set->count; i++) _member_table_insert(set, i);
+}
+
+// Initializes the parts of a set shared by member_set_init and member_set_read.
+void _member_set_init(member_set_t set, pairing_ptr pairing, element_t g) {
+	sig_scheme_init(set->scheme, 1, pairing, g);
+	set->secret_key = NULL;
+	set->public_key = new((type_ptr)set->scheme->public_key_type);
+	set->count = 0;
+	set->capacity = MEMBER_CAPACITY;
+	set->values = (element_t*)pbc_malloc(sizeof(element_t) * set->capacity);
+	set->sigs = (unsigned char*)pbc_malloc(set->scheme->sig_type->base->size * set->capacity);
+	set->table = NULL;
+	_member_table_build(set);
+}
+
+// Appends a value to a set, returning a pointer to the (initialized) space for its
+// signature, which the caller fills in.
+data_ptr _member_set_append(member_set_t set, element_t value) {
+	size_t sig_size = set->scheme->sig_type->base->size;
+	if (set->count == set->capacity) {
+		set->capacity *= 2;
+		set->values = (element_t*)pbc_realloc(set->values, sizeof(element_t) * set->capacity);
+		set->sigs = (unsigned char*)pbc_realloc(set->sigs, sig_size * set->capacity);
+		_member_table_build(set);
+	}
+	int index = set->count++;
+	element_init(set->values[index], set->scheme->Z_type->field);
+	element_set(set->values[index], value);
+	data_ptr sig = member_set_sig(set, index);
+	init((type_ptr)set->scheme->sig_type, sig);
+	_member_table_insert(set, index);
+	return sig;
+}
+
+void member_set_init(member_set_t set, pairing_ptr pairing, element_t g) {
+	_member_set_init(set, pairing, g);
+	set->secret_key = new((type_ptr)set->scheme->secret_key_type);
+	sig_key_setup(set->scheme, set->secret_key, set->public_key);
+}
+
+void member_set_clear(member_set_t set) {
+	int i;
+	for (i = 0; i < set->count; i++) {
+		element_clear(set->values[i]);
+		clear((type_ptr)set->scheme->sig_type, member_set_sig(set, i));
+	}
+	pbc_free(set->values);
+	pbc_free(set->sigs);
+	pbc_free(set->table);
+	if (set->secret_key != NULL) delete((type_ptr)set->scheme->secret_key_type, set->secret_key);
+	delete((type_ptr)set->scheme->public_key_type, set->public_key);
+	sig_scheme_clear(set->scheme);
+}
+
+void member_set_add(member_set_t set, element_t value) {
+	data_ptr sig = _member_set_append(set, value);
+	sig_sign(set->scheme, set->secret_key, sig, &set->values[set->count - 1]);
+}
+
+void member_set_add_si(member_set_t set, long int value) {
+	element_t element; element_init(element, set->scheme->Z_type->field);
+	element_set_si(element, value);
+	member_set_add(set, element);
+	element_clear(element);
+}
+
+int member_set_find(member_set_t set, element_t value) {
+	size_t mask = set->table_size - 1;
+	size_t slot = _member_hash(value) & mask;
+	while (set->table[slot] >= 0) {
+		if (!element_cmp(set->values[set->table[slot]], value)) return set->table[slot];
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+data_ptr member_set_sig(member_set_t set, int index) {
+	return (data_ptr)(set->sigs + set->scheme->sig_type->base->size * index);
+}
+
+int member_set_witness(member_set_t set, element_t value, data_ptr sig) {
+	int index = member_set_find(set, value);
+	if (index < 0) return 0;
+	copy((type_ptr)set->scheme->sig_type, sig, member_set_sig(set, index));
+	return 1;
+}
+
+void member_set_write(member_set_t set, FILE* stream) {
+	int i;
+	write((type_ptr)set->scheme->public_key_type, set->public_key, stream);
+	u64_write(set->count, stream);
+	for (i = 0; i < set->count; i++) {
+		element_write(set->scheme->Z_type->field, set->values[i], stream);
+		write((type_ptr)set->scheme->sig_type, member_set_sig(set, i), stream);
+	}
+}
+
+int member_set_read(member_set_t set, pairing_ptr pairing, element_t g, FILE* stream) {
+	uint64_t i, count;
+	_member_set_init(set, pairing, g);
+	read((type_ptr)set->scheme->public_key_type, set->public_key, stream);
+	if (ferror(stream) || u64_read(&count, stream) != 8 || count > INT_MAX) goto fail;
+	element_t value; element_init(value, set->scheme->Z_type->field);
+	for (i = 0; i < count; i++) {
+		if (element_read(set->scheme->Z_type->field, value, stream) == 0) break;
+		read((type_ptr)set->scheme->sig_type, _member_set_append(set, value), stream);
+		if (ferror(stream) || feof(stream)) break;
+	}
+	element_clear(value);
+	if (i < count) goto fail;
+	return 1;
+	
+fail:
+	member_set_clear(set);
+	return 0;
+}
+
+void require_member(proof_t proof, member_set_t set, supplement_t* sig, var_t var) {
+	require_sig(proof, set->scheme, set->public_key, sig, var);
+}
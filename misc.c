@@ -1,9 +1,98 @@
+#include <limits.h>
 #include <stdint.h>
+#include <string.h>
+#include <pthread.h>
 #include <pbc.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "zkp_io.h"
 #include "zkp_proof.h"
 #include "zkp_internal.h"
 
+// The bound on the odd primes kept for sieving, and the number of them.
+#define SIEVE_MAX 65536
+#define SIEVE_MAX_PRIMES 6541
+
+// The number of candidates sieved at once.
+#define SIEVE_WINDOW 2048
+
+// The smallest candidate size, in bits, for which candidates are sieved. Below this, the
+// trial division done by mpz_probab_prime_p is already cheaper than setting up a sieve.
+#define SIEVE_MIN_BITS 192
+
+// The bound on the primes candidates are sieved by, per bit of candidate size.
+#define SIEVE_BOUND_PER_BIT 8
+
+// The number of Miller-Rabin rounds for candidate primes. Few are needed, since a
+// composite that passes is caught when mpz_decompose_prime checks its result.
+#define DECOMPOSE_PRIME_REPS 2
+
+// The smallest candidate size, in bits, for which several candidates are tested at once
+// on different threads.
+#define DECOMPOSE_PARALLEL_BITS 256
+
+// The largest number of candidates tested at once.
+#define DECOMPOSE_BATCH 16
+
+// The odd primes below SIEVE_MAX, computed on first use.
+static unsigned long sieve_primes[SIEVE_MAX_PRIMES];
+static pthread_once_t sieve_once = PTHREAD_ONCE_INIT;
+
+void _sieve_primes_init(void) {
+	unsigned long i, j; int count = 0;
+	static unsigned char composite[SIEVE_MAX];
+	for (i = 3; i < SIEVE_MAX; i += 2) {
+		if (composite[i]) continue;
+		sieve_primes[count++] = i;
+		for (j = i * i; j < SIEVE_MAX; j += 2 * i) composite[j] = 1;
+	}
+}
+
+// Computes b ^ e (mod q) for q below SIEVE_MAX.
+unsigned long _powmod_ui(unsigned long b, unsigned long e, unsigned long q) {
+	unsigned long result = 1;
+	b %= q;
+	while (e > 0) {
+		if (e & 1) result = result * b % q;
+		b = b * b % q;
+		e >>= 1;
+	}
+	return result;
+}
+
+// Finds a square root of a non-zero a modulo an odd prime q below SIEVE_MAX using the
+// Tonelli-Shanks algorithm, returning q if a is not a square.
+unsigned long _sqrtmod_ui(unsigned long a, unsigned long q) {
+	if (_powmod_ui(a, (q - 1) / 2, q) != 1) return q;
+	if (q % 4 == 3) return _powmod_ui(a, (q + 1) / 4, q);
+	
+	// q - 1 = m * 2 ^ e, with m odd
+	unsigned long m = q - 1; int e = 0;
+	while (!(m & 1)) { m >>= 1; e++; }
+	
+	// z = a quadratic non-residue
+	unsigned long z = 2;
+	while (_powmod_ui(z, (q - 1) / 2, q) == 1) z++;
+	
+	unsigned long c = _powmod_ui(z, m, q);
+	unsigned long t = _powmod_ui(a, m, q);
+	unsigned long x = _powmod_ui(a, (m + 1) / 2, q);
+	while (t != 1) {
+		
+		// Find the least i such that t ^ (2 ^ i) = 1.
+		int i = 0; unsigned long tt = t;
+		while (tt != 1) { tt = tt * tt % q; i++; }
+		unsigned long f = c; int j;
+		for (j = 0; j < e - i - 1; j++) f = f * f % q;
+		x = x * f % q;
+		c = f * f % q;
+		t = t * c % q;
+		e = i;
+	}
+	return x;
+}
+
 int mpz_decompose_prime(mpz_t a, mpz_t b, mpz_t n) {
 	// f = n - 1
 	mpz_t f; mpz_init(f);
@@ -20,30 +109,28 @@ int mpz_decompose_prime(mpz_t a, mpz_t b, mpz_t n) {
 		
 	} else  {
 		
-		// b = 3
-		mpz_set_ui(b, 3);
-		
-		// f = (n - 1) / 2
-		mpz_tdiv_q_2exp(f, f, 1);
-		
-		// t = b ^ ((n - 1) / 2) (mod n)
-		mpz_t t; mpz_init(t);
-		mpz_powm(t, b, f, n);
+		// f = (n - 1) / 4
+		mpz_tdiv_q_2exp(f, f, 2);
 		
-		// while b ^ ((n - 1) / 2) = 1 (mod n)
-		while (!mpz_cmp_ui(t, 1)) {
-			
-			// b = next prime after b
+		// Find a quadratic non-residue b by its Jacobi symbol, which is much cheaper than
+		// computing b ^ ((n - 1) / 2) (mod n). Only primes need be tried, and the least
+		// non-residue is small, so the table nearly always suffices.
+		int i; int symbol = 1;
+		pthread_once(&sieve_once, &_sieve_primes_init);
+		for (i = 0; i < SIEVE_MAX_PRIMES && symbol == 1; i++) {
+			mpz_set_ui(b, sieve_primes[i]);
+			symbol = mpz_ui_kronecker(sieve_primes[i], n);
+		}
+		while (symbol == 1) {
 			mpz_nextprime(b, b);
-			
-			// t = b ^ ((n - 1) / 2) (mod n)
-			mpz_powm(t, b, f, n);
+			symbol = mpz_jacobi(b, n);
 		}
 		
-		// f = (n - 1) / 4
-		mpz_tdiv_q_2exp(f, f, 1);
-		
-		mpz_clear(t);
+		// A symbol of zero means n has a small factor, unless n is that factor.
+		if (symbol == 0) {
+			mpz_clear(f);
+			return 0;
+		}
 	}
 	
 	// b = b ^ ((n - 1) / 4) (mod n)
@@ -71,6 +158,12 @@ int mpz_decompose_prime(mpz_t a, mpz_t b, mpz_t n) {
 	}
 	mpz_clear(bb);
 	
+	// This only happens when n is not prime.
+	if (!mpz_sgn(b)) {
+		mpz_clear(f);
+		return 0;
+	}
+	
 	// a = a % b
 	mpz_mod(a, a, b);
 	
@@ -84,6 +177,120 @@ int mpz_decompose_prime(mpz_t a, mpz_t b, mpz_t n) {
 	
 }
 
+// Tests a batch of candidates, in parallel if there are several, and decomposes the first
+// that is prime as x ^ 2 + y ^ 2, setting b to its base. Returns zero if none decompose.
+int _decompose_test(mpz_t b, mpz_t x, mpz_t y, mpz_t* candidates, mpz_t* bases, int count) {
+	int i; int is_prime[DECOMPOSE_BATCH];
+	
+	// Entering a parallel region costs more than testing a small candidate, even when it
+	// runs on one thread, so it is avoided entirely for single candidates.
+	if (count == 1) {
+		is_prime[0] = mpz_probab_prime_p(candidates[0], DECOMPOSE_PRIME_REPS);
+	} else {
+		#pragma omp parallel for
+		for (i = 0; i < count; i++) {
+			is_prime[i] = mpz_probab_prime_p(candidates[i], DECOMPOSE_PRIME_REPS);
+		}
+	}
+	for (i = 0; i < count; i++) {
+		if (is_prime[i] && mpz_decompose_prime(x, y, candidates[i])) {
+			mpz_set(b, bases[i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Steps b down by 2 until p = r - b ^ 2 (halved, if halve is set) is a prime, and
+// decomposes it as x ^ 2 + y ^ 2. Candidate k has base b - 2k, and a small odd prime q
+// divides it exactly when (b - 2k) ^ 2 = r (mod q), so the candidates q divides can be
+// found from the square roots of r modulo q and struck out of a window of candidates
+// without any multiple-precision arithmetic. mpz_probab_prime_p only trial divides up to
+// the bit length of a candidate, so sieving further leaves fewer candidates for a full
+// probable prime test. The survivors are tested in batches, in parallel if they are large
+// enough, and the first (largest b) that decomposes is used.
+void _decompose_search(mpz_t b, mpz_t x, mpz_t y, mpz_t r, int halve) {
+	int i, j;
+	size_t bits = mpz_sizeinbase(r, 2) / 2;
+	
+	// Sieve by primes up to a bound proportional to the candidate size, which balances
+	// the cost of finding the square roots of r against the tests it saves. The first
+	// candidate may be smaller than the primes, so it is never struck out.
+	unsigned long bound = 0;
+	if (bits >= SIEVE_MIN_BITS) bound = bits * SIEVE_BOUND_PER_BIT < SIEVE_MAX ? bits * SIEVE_BOUND_PER_BIT : SIEVE_MAX;
+	int num_primes = 0;
+	unsigned long *next = NULL;
+	if (bound > 0) {
+		pthread_once(&sieve_once, &_sieve_primes_init);
+		while (num_primes < SIEVE_MAX_PRIMES && sieve_primes[num_primes] < bound) num_primes++;
+		next = (unsigned long*)pbc_malloc(sizeof(unsigned long) * 2 * num_primes);
+		for (j = 0; j < num_primes; j++) {
+			unsigned long q = sieve_primes[j];
+			unsigned long r_q = mpz_fdiv_ui(r, q);
+			unsigned long b_q = mpz_fdiv_ui(b, q);
+			unsigned long half = (q + 1) / 2;
+			
+			// 2k = b -/+ s (mod q), where s ^ 2 = r (mod q)
+			unsigned long s = r_q ? _sqrtmod_ui(r_q, q) : 0;
+			if (s == q) {
+				next[2 * j] = next[2 * j + 1] = ULONG_MAX;
+			} else {
+				next[2 * j] = (b_q + q - s) % q * half % q;
+				next[2 * j + 1] = s ? (b_q + s) % q * half % q : ULONG_MAX;
+			}
+		}
+	}
+	
+	int batch = 1;
+#ifdef _OPENMP
+	if (bits >= DECOMPOSE_PARALLEL_BITS) batch = omp_get_max_threads();
+	if (batch > DECOMPOSE_BATCH) batch = DECOMPOSE_BATCH;
+#endif
+	mpz_t candidates[DECOMPOSE_BATCH];
+	mpz_t bases[DECOMPOSE_BATCH];
+	for (i = 0; i < batch; i++) {
+		mpz_init(candidates[i]);
+		mpz_init(bases[i]);
+	}
+	
+	unsigned char composite[SIEVE_WINDOW];
+	unsigned long start = 0; int count = 0;
+	for (;;) {
+		
+		// Strike out the candidates in [start, start + SIEVE_WINDOW) with small factors.
+		unsigned long end = start + SIEVE_WINDOW;
+		memset(composite, 0, sizeof(composite));
+		for (j = 0; j < 2 * num_primes; j++) {
+			unsigned long k; unsigned long q = sieve_primes[j / 2];
+			for (k = next[j]; k < end; k += q) composite[k - start] = 1;
+			if (next[j] != ULONG_MAX) next[j] = k;
+		}
+		if (start == 0) composite[0] = 0;
+		
+		for (i = 0; i < SIEVE_WINDOW; i++) {
+			if (composite[i]) continue;
+			
+			// p = r - (b - 2k) ^ 2, halved if needed
+			mpz_sub_ui(bases[count], b, 2 * (start + i));
+			mpz_set(candidates[count], r);
+			mpz_submul(candidates[count], bases[count], bases[count]);
+			if (halve) mpz_tdiv_q_2exp(candidates[count], candidates[count], 1);
+			if (++count == batch) {
+				if (_decompose_test(b, x, y, candidates, bases, count)) goto end;
+				count = 0;
+			}
+		}
+		start = end;
+	}
+	
+end:
+	for (i = 0; i < batch; i++) {
+		mpz_clear(candidates[i]);
+		mpz_clear(bases[i]);
+	}
+	if (next != NULL) pbc_free(next);
+}
+
 void mpz_decompose(mpz_t a, mpz_t b, mpz_t c, mpz_t d, mpz_t n) {
 	unsigned long v;
 	
@@ -152,40 +359,20 @@ void mpz_decompose(mpz_t a, mpz_t b, mpz_t c, mpz_t d, mpz_t n) {
 	}
 	
 	// If r = 3 (mod 8)
-	mpz_t p; mpz_init(p);
 	if (mpz_congruent_ui_p(r, 3, 8)) {
 		mpz_t x; mpz_init(x);
 		mpz_t y; mpz_init(y);
 	
 		// Find the largest odd b such that (r - b ^ 2) / 2 is a prime.
 		mpz_sqrt(b, r); if (mpz_even_p(b)) mpz_sub_ui(b, b, 1);
-		for (;;) {
+		_decompose_search(b, x, y, r, 1);
 		
-			// p = (r - b ^ 2) / 2
-			mpz_set(p, r);
-			mpz_submul(p, b, b);
-			mpz_tdiv_q_2exp(p, p, 1);
-			
-			// verify p is a prime.
-			if (mpz_probab_prime_p(p, 20)) {
-			
-				// decompose p.
-				if (mpz_decompose_prime(x, y, p)) {
-					
-					// c = x + y
-					mpz_add(c, x, y);
-					
-					// d = abs (x - y)
-					mpz_sub(d, x, y);
-					mpz_abs(d, d);
-				
-					break;
-				}
-			}
+		// c = x + y
+		mpz_add(c, x, y);
 		
-			// b = b - 2
-			mpz_sub_ui(b, b, 2);
-		}
+		// d = abs (x - y)
+		mpz_sub(d, x, y);
+		mpz_abs(d, d);
 		
 		mpz_clear(x);
 		mpz_clear(y);
@@ -193,23 +380,7 @@ void mpz_decompose(mpz_t a, mpz_t b, mpz_t c, mpz_t d, mpz_t n) {
 		
 		// Find the largest b such that r - b ^ 2 is a prime.
 		mpz_sqrt(b, r); if (mpz_even_p(r) ^ mpz_odd_p(b)) mpz_sub_ui(b, b, 1);
-		for (;;) {
-		
-			// p = r - b ^ 2
-			mpz_set(p, r);
-			mpz_submul(p, b, b);
-			
-			// verify p is a prime.
-			if (mpz_probab_prime_p(p, 20)) {
-			
-				// decompose p into c and d.
-				if (mpz_decompose_prime(c, d, p)) break;
-			}
-		
-			// b = b - 2
-			mpz_sub_ui(b, b, 2);
-		}
-	
+		_decompose_search(b, c, d, r, 0);
 	}
 	
 end:
@@ -217,5 +388,95 @@ end:
 	mpz_mul_2exp(c, c, v);
 	mpz_mul_2exp(d, d, v);
 	mpz_clear(r);
-	mpz_clear(p);
+}
+
+// The number of bases from which element_multi_pow uses buckets rather than combining the
+// bases three at a time.
+#define MULTI_POW_BUCKET_MIN 32
+
+// Computes a multi-exponentiation by the bucket method: the exponents are cut into windows
+// of c bits, and for each window (from the top) the bases are sorted into buckets by their
+// digit, so that the sum of digit * base costs one multiplication per base and two per
+// bucket, rather than an exponentiation per base.
+void _multi_pow_buckets(element_t out, int count, element_ptr* bases, element_ptr* exps) {
+	int i, j, w;
+	int c = 2;
+	while (c < 12 && (count >> (c + 2)) != 0) c++;
+	int num_buckets = (1 << c) - 1;
+	size_t bits = 0;
+	mpz_t *digits = (mpz_t*)pbc_malloc(sizeof(mpz_t) * count);
+	for (i = 0; i < count; i++) {
+		mpz_init(digits[i]);
+		element_to_mpz(digits[i], exps[i]);
+		size_t size = mpz_sizeinbase(digits[i], 2);
+		if (size > bits) bits = size;
+	}
+	element_t *buckets = (element_t*)pbc_malloc(sizeof(element_t) * num_buckets);
+	char *used = (char*)pbc_malloc(num_buckets);
+	for (j = 0; j < num_buckets; j++) element_init_same_as(buckets[j], out);
+	element_t running; element_init_same_as(running, out);
+	element_t sum; element_init_same_as(sum, out);
+	
+	element_set1(out);
+	for (w = (int)((bits + c - 1) / c) - 1; w >= 0; w--) {
+		for (j = 0; j < c; j++) element_square(out, out);
+		memset(used, 0, num_buckets);
+		for (i = 0; i < count; i++) {
+			unsigned long digit = 0;
+			for (j = c - 1; j >= 0; j--) digit = (digit << 1) | mpz_tstbit(digits[i], (mp_bitcnt_t)w * c + j);
+			if (digit == 0) continue;
+			if (used[digit - 1]) element_mul(buckets[digit - 1], buckets[digit - 1], bases[i]);
+			else element_set(buckets[digit - 1], bases[i]);
+			used[digit - 1] = 1;
+		}
+		
+		// sum = bucket_1 ^ 1 * bucket_2 ^ 2 * ..., as a product of suffix products
+		element_set1(running);
+		element_set1(sum);
+		for (j = num_buckets - 1; j >= 0; j--) {
+			if (used[j]) element_mul(running, running, buckets[j]);
+			element_mul(sum, sum, running);
+		}
+		element_mul(out, out, sum);
+	}
+	
+	for (i = 0; i < count; i++) mpz_clear(digits[i]);
+	for (j = 0; j < num_buckets; j++) element_clear(buckets[j]);
+	pbc_free(digits);
+	pbc_free(buckets);
+	pbc_free(used);
+	element_clear(running);
+	element_clear(sum);
+}
+
+void element_multi_pow(element_t out, int count, element_ptr* bases, element_ptr* exps) {
+	int i;
+	if (count >= MULTI_POW_BUCKET_MIN) {
+		_multi_pow_buckets(out, count, bases, exps);
+		return;
+	}
+	element_t temp; element_init_same_as(temp, out);
+	element_set1(out);
+	for (i = 0; i + 3 <= count; i += 3) {
+		element_pow3_zn(temp, bases[i], exps[i], bases[i + 1], exps[i + 1], bases[i + 2], exps[i + 2]);
+		element_mul(out, out, temp);
+	}
+	if (count - i == 2) {
+		element_pow2_zn(temp, bases[i], exps[i], bases[i + 1], exps[i + 1]);
+		element_mul(out, out, temp);
+	} else if (count - i == 1) {
+		element_pow_zn(temp, bases[i], exps[i]);
+		element_mul(out, out, temp);
+	}
+	element_clear(temp);
+}
+
+void element_from_label(element_t out, const char* label, uint64_t index) {
+	int i; unsigned char data[8]; unsigned char digest[32];
+	sha256_t ctx; sha256_init(ctx);
+	sha256_update(ctx, (const unsigned char*)label, strlen(label));
+	for (i = 0; i < 8; i++) data[i] = index >> (56 - 8 * i);
+	sha256_update(ctx, data, 8);
+	sha256_final(ctx, digest);
+	element_from_hash(out, digest, 32);
 }
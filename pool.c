@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pbc.h>
+#include "zkp_pool.h"
+
+// The number of size classes, which are powers of two from POOL_MIN_SIZE bytes.
+#define POOL_CLASSES 7
+#define POOL_MIN_SIZE 16
+
+// The maximum number of free blocks cached by each thread in each size class.
+#define POOL_CACHE_MAX 256
+
+// The header stored before each block. It keeps the size class (or POOL_CLASSES for
+// large blocks) and the usable size, and preserves 16-byte alignment.
+typedef struct pool_header_s {
+	size_t size;
+	size_t size_class;
+} pool_header_t;
+
+typedef struct pool_free_s {
+	struct pool_free_s *next;
+} pool_free_t;
+
+// The cache and statistics of one thread.
+typedef struct pool_thread_s {
+	pool_free_t *free[POOL_CLASSES];
+	int count[POOL_CLASSES];
+	struct pool_stats_s stats;
+	struct pool_thread_s *prev, *next;
+} pool_thread_t;
+
+static __thread pool_thread_t *pool_current = NULL;
+
+// All live thread caches, and the statistics of threads that have exited.
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t pool_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+static pool_thread_t *pool_threads = NULL;
+static struct pool_stats_s pool_retired;
+
+void _pool_thread_exit(void*);
+void _pool_key_create(void) {
+	pthread_key_create(&pool_key, &_pool_thread_exit);
+}
+
+pool_thread_t *_pool_thread(void) {
+	pool_thread_t *self = pool_current;
+	if (self != NULL) return self;
+	self = (pool_thread_t*)calloc(1, sizeof(pool_thread_t));
+	pthread_once(&pool_key_once, &_pool_key_create);
+	pthread_setspecific(pool_key, self);
+	pthread_mutex_lock(&pool_lock);
+	self->next = pool_threads;
+	if (pool_threads != NULL) pool_threads->prev = self;
+	pool_threads = self;
+	pthread_mutex_unlock(&pool_lock);
+	pool_current = self;
+	return self;
+}
+
+void _pool_thread_trim(pool_thread_t *self) {
+	int i;
+	for (i = 0; i < POOL_CLASSES; i++) {
+		while (self->free[i] != NULL) {
+			pool_free_t *block = self->free[i];
+			self->free[i] = block->next;
+			free((pool_header_t*)block - 1);
+		}
+		self->count[i] = 0;
+	}
+}
+
+void _pool_thread_exit(void* data) {
+	pool_thread_t *self = (pool_thread_t*)data;
+	_pool_thread_trim(self);
+	pthread_mutex_lock(&pool_lock);
+	pool_retired.allocs += self->stats.allocs;
+	pool_retired.hits += self->stats.hits;
+	pool_retired.frees += self->stats.frees;
+	pool_retired.cached += self->stats.cached;
+	pool_retired.large += self->stats.large;
+	if (self->prev != NULL) self->prev->next = self->next;
+	else pool_threads = self->next;
+	if (self->next != NULL) self->next->prev = self->prev;
+	pthread_mutex_unlock(&pool_lock);
+	pool_current = NULL;
+	free(self);
+}
+
+int _pool_class(size_t size) {
+	int i; size_t class_size = POOL_MIN_SIZE;
+	for (i = 0; i < POOL_CLASSES; i++, class_size <<= 1) {
+		if (size <= class_size) return i;
+	}
+	return POOL_CLASSES;
+}
+
+void *_pool_malloc(size_t size) {
+	pool_thread_t *self = _pool_thread();
+	int size_class = _pool_class(size);
+	pool_header_t *header;
+	if (size_class == POOL_CLASSES) {
+		__atomic_fetch_add(&self->stats.large, 1, __ATOMIC_RELAXED);
+		header = (pool_header_t*)malloc(sizeof(pool_header_t) + size);
+		if (header == NULL) pbc_die("out of memory");
+		header->size = size;
+	} else {
+		__atomic_fetch_add(&self->stats.allocs, 1, __ATOMIC_RELAXED);
+		pool_free_t *block = self->free[size_class];
+		if (block != NULL) {
+			__atomic_fetch_add(&self->stats.hits, 1, __ATOMIC_RELAXED);
+			self->free[size_class] = block->next;
+			self->count[size_class]--;
+			return block;
+		}
+		header = (pool_header_t*)malloc(sizeof(pool_header_t) + ((size_t)POOL_MIN_SIZE << size_class));
+		if (header == NULL) pbc_die("out of memory");
+		header->size = (size_t)POOL_MIN_SIZE << size_class;
+	}
+	header->size_class = size_class;
+	return header + 1;
+}
+
+void _pool_free(void *data) {
+	if (data == NULL) return;
+	pool_header_t *header = (pool_header_t*)data - 1;
+	int size_class = (int)header->size_class;
+	if (size_class < POOL_CLASSES) {
+		pool_thread_t *self = _pool_thread();
+		__atomic_fetch_add(&self->stats.frees, 1, __ATOMIC_RELAXED);
+		if (self->count[size_class] < POOL_CACHE_MAX) {
+			pool_free_t *block = (pool_free_t*)data;
+			__atomic_fetch_add(&self->stats.cached, 1, __ATOMIC_RELAXED);
+			block->next = self->free[size_class];
+			self->free[size_class] = block;
+			self->count[size_class]++;
+			return;
+		}
+	}
+	free(header);
+}
+
+void *_pool_realloc(void *data, size_t size) {
+	if (data == NULL) return _pool_malloc(size);
+	pool_header_t *header = (pool_header_t*)data - 1;
+	if (size <= header->size) return data;
+	void *result = _pool_malloc(size);
+	memcpy(result, data, header->size);
+	_pool_free(data);
+	return result;
+}
+
+void *_pool_mp_realloc(void *data, size_t old_size, size_t new_size) {
+	return _pool_realloc(data, new_size);
+}
+
+void _pool_mp_free(void *data, size_t size) {
+	_pool_free(data);
+}
+
+void pool_install(void) {
+	pbc_set_memory_functions(&_pool_malloc, &_pool_realloc, &_pool_free);
+	mp_set_memory_functions(&_pool_malloc, &_pool_mp_realloc, &_pool_mp_free);
+}
+
+void pool_stats(pool_stats_t stats) {
+	pool_thread_t *current;
+	pthread_mutex_lock(&pool_lock);
+	*stats = pool_retired;
+	for (current = pool_threads; current != NULL; current = current->next) {
+		stats->allocs += __atomic_load_n(&current->stats.allocs, __ATOMIC_RELAXED);
+		stats->hits += __atomic_load_n(&current->stats.hits, __ATOMIC_RELAXED);
+		stats->frees += __atomic_load_n(&current->stats.frees, __ATOMIC_RELAXED);
+		stats->cached += __atomic_load_n(&current->stats.cached, __ATOMIC_RELAXED);
+		stats->large += __atomic_load_n(&current->stats.large, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&pool_lock);
+}
+
+void pool_trim(void) {
+	if (pool_current != NULL) _pool_thread_trim(pool_current);
+}
@@ -0,0 +1,215 @@
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_precomp.h"
+
+void fixed_base_init(fixed_base_t table, element_t base, int bits) {
+	int i, j;
+	table->field = base->field;
+	table->bytes = NULL;
+	table->slot_size = 0;
+	table->windows = (bits + FIXED_BASE_WINDOW - 1) / FIXED_BASE_WINDOW;
+	table->powers = (element_t*)pbc_malloc(sizeof(element_t) * table->windows * FIXED_BASE_WINDOW_SIZE);
+	for (i = 0; i < table->windows; i++) {
+		element_t *window = table->powers + i * FIXED_BASE_WINDOW_SIZE;
+		
+		// window_0 = base ^ (2 ^ (FIXED_BASE_WINDOW * i))
+		element_init(window[0], table->field);
+		if (i == 0) element_set(window[0], base);
+		else element_mul(window[0], window[-1], window[-FIXED_BASE_WINDOW_SIZE]);
+		
+		// window_j = window_0 ^ (j + 1)
+		for (j = 1; j < FIXED_BASE_WINDOW_SIZE; j++) {
+			element_init(window[j], table->field);
+			element_mul(window[j], window[j - 1], window[0]);
+		}
+	}
+}
+
+void fixed_base_clear(fixed_base_t table) {
+	int i;
+	if (table->powers == NULL) return;
+	for (i = 0; i < table->windows * FIXED_BASE_WINDOW_SIZE; i++) {
+		element_clear(table->powers[i]);
+	}
+	pbc_free(table->powers);
+}
+
+void fixed_base_pow_zn(element_t out, fixed_base_t table, element_t exp) {
+	int i, j;
+	mpz_t e; mpz_init(e);
+	element_t power;
+	if (table->powers == NULL) element_init(power, table->field);
+	element_to_mpz(e, exp);
+	element_set1(out);
+	for (i = 0; i < table->windows; i++) {
+		int digit = 0;
+		for (j = 0; j < FIXED_BASE_WINDOW; j++) {
+			digit |= mpz_tstbit(e, i * FIXED_BASE_WINDOW + j) << j;
+		}
+		if (!digit) continue;
+		int index = i * FIXED_BASE_WINDOW_SIZE + digit - 1;
+		if (table->powers != NULL) {
+			element_mul(out, out, table->powers[index]);
+		} else {
+			element_from_bytes(power, (unsigned char*)table->bytes + index * table->slot_size + 4);
+			element_mul(out, out, power);
+		}
+	}
+	if (table->powers == NULL) element_clear(power);
+	mpz_clear(e);
+}
+
+void fixed_base_write(fixed_base_t table, FILE* stream) {
+	int i;
+	u64_write(table->windows, stream);
+	for (i = 0; i < table->windows * FIXED_BASE_WINDOW_SIZE; i++) {
+		element_write(table->field, table->powers[i], stream);
+	}
+}
+
+size_t fixed_base_init_bytes(fixed_base_t table, field_ptr field, const unsigned char* bytes, size_t size) {
+	int i; uint64_t windows;
+	size_t len = u64_read_bytes(&windows, bytes, size);
+	if (read_failed(len)) return len;
+	if (windows == 0 || windows > 1024) return READ_ERROR;
+	element_t sample; element_init(sample, field);
+	uint32_t element_size = element_length_in_bytes(sample);
+	element_clear(sample);
+	
+	// Every slot must hold an element of the expected size; the elements themselves are
+	// only decoded when they are used.
+	int count = (int)windows * FIXED_BASE_WINDOW_SIZE;
+	size_t slot_size = 4 + (size_t)element_size;
+	if ((size - len) / slot_size < (size_t)count) return READ_INCOMPLETE;
+	for (i = 0; i < count; i++) {
+		const unsigned char *slot = bytes + len + i * slot_size;
+		uint32_t slot_element_size = (slot[0] << 24) | (slot[1] << 16) | (slot[2] << 8) | (slot[3] << 0);
+		if (slot_element_size != element_size) return READ_ERROR;
+	}
+	table->field = field;
+	table->windows = (int)windows;
+	table->powers = NULL;
+	table->bytes = bytes + len;
+	table->slot_size = slot_size;
+	return len + count * slot_size;
+}
+
+static const unsigned char cache_magic[4] = { 'Z', 'K', 'P', 'C' };
+static const uint32_t cache_version = 3;
+
+// The size of the header at the start of a cache file: magic, version, payload size and
+// parameter hash.
+#define CACHE_HEADER_SIZE 24
+
+void cache_write(FILE* stream, const char* param, size_t param_size, element_t g, element_t h) {
+	int i;
+	int bits = mpz_sizeinbase(g->field->order, 2);
+	fixed_base_t table;
+	
+	// Build the payload in memory so that its size can be written before it.
+	char *payload; size_t payload_size;
+	FILE* payload_stream = open_memstream(&payload, &payload_size);
+	u64_write(param_size, payload_stream);
+	fwrite(param, 1, param_size, payload_stream);
+	element_write(g->field, g, payload_stream);
+	element_write(h->field, h, payload_stream);
+	fixed_base_init(table, g, bits);
+	fixed_base_write(table, payload_stream);
+	fixed_base_clear(table);
+	fixed_base_init(table, h, bits);
+	fixed_base_write(table, payload_stream);
+	fixed_base_clear(table);
+	fclose(payload_stream);
+	
+	unsigned char header[CACHE_HEADER_SIZE];
+	memset(header, 0, sizeof(header));
+	memcpy(header, cache_magic, 4);
+	header[4] = cache_version >> 24;
+	header[5] = cache_version >> 16;
+	header[6] = cache_version >> 8;
+	header[7] = cache_version >> 0;
+	for (i = 0; i < 8; i++) header[8 + i] = (uint64_t)payload_size >> (56 - 8 * i);
+	uint64_t param_hash = hash_bytes((const unsigned char*)param, param_size);
+	for (i = 0; i < 8; i++) header[16 + i] = param_hash >> (56 - 8 * i);
+	fwrite(header, 1, sizeof(header), stream);
+	fwrite(payload, 1, payload_size, stream);
+	free(payload);
+}
+
+int cache_open(cache_t cache, const char* path, const char* param, size_t param_size) {
+	struct stat info;
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) return 0;
+	if (fstat(fileno(file), &info) < 0 || info.st_size < CACHE_HEADER_SIZE) {
+		fclose(file);
+		return 0;
+	}
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fileno(file), 0);
+	fclose(file);
+	if (data == MAP_FAILED) return 0;
+	cache->data = (const unsigned char*)data;
+	cache->size = info.st_size;
+	
+	// Validate the header rather than hashing the whole payload, so that opening does not
+	// touch every page of the mapping. The reads below are bounded by the payload size.
+	const unsigned char *header = cache->data;
+	uint32_t version = (header[4] << 24) | (header[5] << 16) | (header[6] << 8) | (header[7] << 0);
+	uint64_t payload_size, param_hash;
+	u64_read_bytes(&payload_size, header + 8, 8);
+	u64_read_bytes(&param_hash, header + 16, 8);
+	const unsigned char *bytes = cache->data + CACHE_HEADER_SIZE;
+	size_t size = cache->size - CACHE_HEADER_SIZE;
+	if (memcmp(header, cache_magic, 4) || version != cache_version || payload_size != size ||
+		param_hash != hash_bytes((const unsigned char*)param, param_size)) goto unmap;
+	
+	// Pairing parameters, which must be the ones asked for.
+	uint64_t cached_param_size;
+	size_t len = u64_read_bytes(&cached_param_size, bytes, size);
+	if (read_failed(len) || cached_param_size != param_size || param_size > size - len) goto unmap;
+	if (memcmp(bytes + len, param, param_size)) goto unmap;
+	if (pairing_init_set_buf(cache->pairing, (const char*)bytes + len, param_size)) goto unmap;
+	bytes += len + param_size; size -= len + param_size;
+	
+	// Commitment bases and their tables.
+	element_init_G1(cache->g, cache->pairing);
+	element_init_G1(cache->h, cache->pairing);
+	len = element_read_bytes(cache->g->field, cache->g, bytes, size);
+	if (read_failed(len)) goto clear_bases;
+	bytes += len; size -= len;
+	len = element_read_bytes(cache->h->field, cache->h, bytes, size);
+	if (read_failed(len)) goto clear_bases;
+	bytes += len; size -= len;
+	len = fixed_base_init_bytes(cache->g_table, cache->g->field, bytes, size);
+	if (read_failed(len)) goto clear_bases;
+	bytes += len; size -= len;
+	len = fixed_base_init_bytes(cache->h_table, cache->h->field, bytes, size);
+	if (read_failed(len)) goto clear_g_table;
+	if (len != size) goto clear_h_table;
+	return 1;
+	
+clear_h_table:
+	fixed_base_clear(cache->h_table);
+clear_g_table:
+	fixed_base_clear(cache->g_table);
+clear_bases:
+	element_clear(cache->g);
+	element_clear(cache->h);
+	pairing_clear(cache->pairing);
+unmap:
+	munmap((void*)cache->data, cache->size);
+	return 0;
+}
+
+void cache_close(cache_t cache) {
+	fixed_base_clear(cache->g_table);
+	fixed_base_clear(cache->h_table);
+	element_clear(cache->g);
+	element_clear(cache->h);
+	pairing_clear(cache->pairing);
+	munmap((void*)cache->data, cache->size);
+}
@@ -1,68 +1,155 @@
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pbc.h>
 #include "zkp_io.h"
 #include "zkp_proof.h"
 #include "zkp_internal.h"
+#include "zkp_precomp.h"
+#include "zkp_arena.h"
 
 void _multi_init(type_ptr, data_ptr);
 void _multi_clear(type_ptr, data_ptr);
 void _multi_write(type_ptr, data_ptr, FILE*);
 void _multi_read(type_ptr, data_ptr, FILE*);
+size_t _multi_read_bytes(type_ptr, data_ptr, const unsigned char*, size_t);
 type_ptr _supplement_type_for_block(block_ptr);
 type_ptr _claim_secret_type_for_block(block_ptr);
 type_ptr _claim_public_type_for_block(block_ptr);
 type_ptr _response_type_for_block(block_ptr);
-void multi_type_init(struct multi_type_s* type, proof_ptr proof, type_ptr (*for_block)(block_ptr)) {
+void multi_type_init(struct multi_type_s* type, proof_ptr proof, type_ptr (*for_block)(block_ptr), int part) {
 	type->base->init = &_multi_init;
 	type->base->clear = &_multi_clear;
 	type->base->write = &_multi_write;
 	type->base->read = &_multi_read;
+	type->base->read_bytes = &_multi_read_bytes;
 	type->base->size = 0;
 	type->proof = proof;
 	type->for_block = for_block;
+	type->part = part;
 }
 
 void proof_init(proof_t proof, field_ptr Z, field_ptr G, element_t g, element_t h) {
 	element_type_init(proof->Z_type, Z);
 	element_type_init(proof->G_type, G);
-	multi_type_init(&proof->supplement_type, proof, &_supplement_type_for_block);
-	multi_type_init(&proof->claim_secret_type, proof, &_claim_secret_type_for_block);
-	multi_type_init(&proof->claim_public_type, proof, &_claim_public_type_for_block);
-	multi_type_init(&proof->response_type, proof, &_response_type_for_block);
+	multi_type_init(&proof->supplement_type, proof, &_supplement_type_for_block, PART_SUPPLEMENT);
+	multi_type_init(&proof->claim_secret_type, proof, &_claim_secret_type_for_block, PART_CLAIM_SECRET);
+	multi_type_init(&proof->claim_public_type, proof, &_claim_public_type_for_block, PART_CLAIM_PUBLIC);
+	multi_type_init(&proof->response_type, proof, &_response_type_for_block, PART_RESPONSE);
 	proof->num_secret = 0;
 	proof->num_public = 0;
+	proof->num_vectors = 0;
+	proof->vectors = NULL;
 	element_init(proof->g, G); element_set(proof->g, g);
 	element_init(proof->h, G); element_set(proof->h, h);
+	proof->g_table = NULL;
+	proof->h_table = NULL;
 	
 	proof->first_computation = NULL;
 	proof->last_computation = NULL;
 	proof->first_block = NULL;
+	proof->num_blocks = 0;
+	proof->plan = NULL;
+	proof->computation_order = NULL;
+	proof->plan_order = NULL;
 }
 
 void proof_clear(proof_t proof) {
+	long i; int j;
 	element_clear(proof->g);
 	element_clear(proof->h);
+	for (i = 0; i < proof->num_vectors; i++) {
+		for (j = 0; j < proof->vectors[i].size; j++) element_clear(proof->vectors[i].generators[j]);
+		pbc_free(proof->vectors[i].generators);
+	}
+	if (proof->vectors != NULL) pbc_free(proof->vectors);
 	computations_clear(proof);
 	blocks_clear(proof);
 }
 
-const long VAR_SECRET_FLAG = 0x80000000;
-const long VAR_INDEX_MASK = 0x7FFFFFFF;
+void proof_set_tables(proof_t proof, fixed_base_ptr g_table, fixed_base_ptr h_table) {
+	proof->g_table = g_table;
+	proof->h_table = h_table;
+}
+
+void proof_pow_gh(proof_t proof, element_t out, element_t a, element_t b) {
+	if (proof->g_table != NULL && proof->h_table != NULL) {
+		element_t temp; element_init(temp, proof->G_type->field);
+		fixed_base_pow_zn(out, proof->g_table, a);
+		fixed_base_pow_zn(temp, proof->h_table, b);
+		element_mul(out, out, temp);
+		element_clear(temp);
+	} else {
+		element_pow2_zn(out, proof->g, a, proof->h, b);
+	}
+}
+
+void proof_pow_h(proof_t proof, element_t out, element_t b) {
+	if (proof->h_table != NULL) fixed_base_pow_zn(out, proof->h_table, b);
+	else element_pow_zn(out, proof->h, b);
+}
+
+const var_t VAR_SECRET_FLAG = (var_t)1 << 63;
+const var_t VAR_INDEX_MASK = ~((var_t)1 << 63);
 
 var_t var_secret(proof_t proof) {
-	var_t var = VAR_SECRET_FLAG | proof->num_secret;
+	var_t var = VAR_SECRET_FLAG | (var_t)proof->num_secret;
 	proof->num_secret++;
 	return var;
 }
 
 var_t var_public(proof_t proof) {
-	var_t var = proof->num_public;
+	var_t var = (var_t)proof->num_public;
 	proof->num_public++;
 	return var;
 }
 
+// Adds a vector over the given existing secret variables to a proof, deriving its
+// generators.
+vec_t _vector_add(proof_t proof, long first, int count) {
+	int i; int size = 1;
+	while (size < count) size *= 2;
+	proof->vectors = (secret_vector_ptr)pbc_realloc(proof->vectors, sizeof(secret_vector_t) * (proof->num_vectors + 1));
+	secret_vector_ptr vector = &proof->vectors[proof->num_vectors];
+	vector->first = first;
+	vector->count = count;
+	vector->size = size;
+	vector->generators = (element_t*)pbc_malloc(sizeof(element_t) * size);
+	for (i = 0; i < size; i++) {
+		element_init(vector->generators[i], proof->G_type->field);
+		element_from_label(vector->generators[i], "zkp vector", ((uint64_t)proof->num_vectors << 32) | i);
+	}
+	return proof->num_vectors++;
+}
+
+vec_t var_secret_vector(proof_t proof, int count, var_t* vars) {
+	int i;
+	assert(count > 0);
+	long first = proof->num_secret;
+	for (i = 0; i < count; i++) vars[i] = var_secret(proof);
+	return _vector_add(proof, first, count);
+}
+
+long secret_vector_find(proof_t proof, long index) {
+	long low = 0, high = proof->num_vectors;
+	while (low < high) {
+		long mid = (low + high) / 2;
+		if (proof->vectors[mid].first + proof->vectors[mid].count <= index) low = mid + 1;
+		else high = mid;
+	}
+	if (low < proof->num_vectors && proof->vectors[low].first <= index) return low;
+	return -1;
+}
+
+int secret_committed(proof_t proof, long index) {
+	long vector = secret_vector_find(proof, index);
+	return vector < 0 || proof->vectors[vector].first == index;
+}
+
 int var_is_secret(var_t var) {
-	return var & VAR_SECRET_FLAG;
+	return (var & VAR_SECRET_FLAG) != 0;
 }
 
 int var_is_public(var_t var) {
@@ -73,8 +160,15 @@ long var_index(var_t var) {
 	return var & VAR_INDEX_MASK;
 }
 
+int var_valid(proof_t proof, var_t var) {
+	if (var_is_secret(var)) return var_index(var) < proof->num_secret;
+	else return var_index(var) < proof->num_public;
+}
+
 long var_secret_index(proof_t proof, var_t var) {
 	if (var_is_secret(var)) {
+		// Members of a vector share one commitment, so they can not be used on their own.
+		if (secret_vector_find(proof, var_index(var)) >= 0) pbc_die("vector member used as a variable");
 		return var_index(var);
 	} else {
 		var_t mirror = var_secret(proof);
@@ -84,71 +178,268 @@ long var_secret_index(proof_t proof, var_t var) {
 	}
 }
 
-void inst_init_prover(proof_t proof, inst_t inst) {
-	int i;
-	inst->secret_values = pbc_malloc(proof->num_secret * sizeof(element_t));
-	inst->secret_openings = pbc_malloc(proof->num_secret * sizeof(element_t));
-	inst->secret_commitments = pbc_malloc(proof->num_secret * sizeof(element_t));
-	inst->public_values = pbc_malloc(proof->num_public * sizeof(element_t));
-	inst->supplement_data = new((type_ptr)&proof->supplement_type);
-	for (i = 0; i < proof->num_secret; i++) {
-		element_init(inst->secret_values[i], proof->Z_type->field);
-		element_init(inst->secret_openings[i], proof->Z_type->field);
-		element_init(inst->secret_commitments[i], proof->G_type->field);
+static const unsigned char proof_magic[4] = { 'Z', 'K', 'P', 'D' };
+static const uint64_t proof_version = 2;
+
+int proof_write(proof_t proof, proof_refs_t refs, FILE* stream) {
+	uint64_t count; long i; int valid = 1;
+	
+	// Header, commitment bases, variable counts and vectors.
+	fwrite(proof_magic, 1, 4, stream);
+	u64_write(proof_version, stream);
+	element_write(proof->G_type->field, proof->g, stream);
+	element_write(proof->G_type->field, proof->h, stream);
+	u64_write(proof->num_secret, stream);
+	u64_write(proof->num_public, stream);
+	u64_write(proof->num_vectors, stream);
+	for (i = 0; i < proof->num_vectors; i++) {
+		u64_write(proof->vectors[i].first, stream);
+		u64_write(proof->vectors[i].count, stream);
 	}
-	for (i = 0; i < proof->num_public; i++) {
-		element_init(inst->public_values[i], proof->Z_type->field);
+	
+	// Computations, in order of application.
+	computation_ptr computation = proof->first_computation;
+	for (count = 0; computation != NULL; computation = computation->next) count++;
+	u64_write(count, stream);
+	for (computation = proof->first_computation; computation != NULL; computation = computation->next) {
+		u64_write(computation->kind, stream);
+		computation->write(computation, proof, stream);
 	}
 	
+	// Blocks, in order of insertion (the reverse of the order they are listed in).
+	block_ptr block = proof->first_block;
+	for (count = 0; block != NULL; block = block->next) count++;
+	block_ptr *blocks = (block_ptr*)pbc_malloc(sizeof(block_ptr) * count);
+	for (count = 0, block = proof->first_block; block != NULL; block = block->next) blocks[count++] = block;
+	u64_write(count, stream);
+	while (count > 0 && valid) {
+		block = blocks[--count];
+		u64_write(block->kind, stream);
+		valid = block->write(block, proof, refs, stream);
+	}
+	pbc_free(blocks);
+	return valid && !ferror(stream);
 }
 
-void inst_init_verifier(proof_t proof, inst_t inst) {
-	int i;
-	inst->secret_values = NULL;
-	inst->secret_openings = NULL;
-	inst->secret_commitments = pbc_malloc(proof->num_secret * sizeof(element_t));
-	inst->public_values = pbc_malloc(proof->num_public * sizeof(element_t));
-	inst->supplement_data = new((type_ptr)&proof->supplement_type);
-	for (i = 0; i < proof->num_secret; i++) {
-		element_init(inst->secret_commitments[i], proof->G_type->field);
+int proof_digest(proof_t proof, proof_refs_t refs, unsigned char digest[32]) {
+	char *bytes; size_t size;
+	sha256_t ctx;
+	FILE* stream = open_memstream(&bytes, &size);
+	int valid = proof_write(proof, refs, stream);
+	fclose(stream);
+	sha256_init(ctx);
+	sha256_update(ctx, (unsigned char*)bytes, size);
+	sha256_final(ctx, digest);
+	free(bytes);
+	return valid;
+}
+
+int proof_read(proof_t proof, field_ptr Z, field_ptr G, proof_refs_t refs, FILE* stream) {
+	unsigned char magic[4];
+	uint64_t i, version, num_secret, num_public, count, kind, first, length, end;
+	if (fread(magic, 1, 4, stream) != 4 || memcmp(magic, proof_magic, 4)) return 0;
+	if (u64_read(&version, stream) != 8 || version != proof_version) return 0;
+	element_t g; element_init(g, G);
+	element_t h; element_init(h, G);
+	int valid = element_read(G, g, stream) && element_read(G, h, stream);
+	proof_init(proof, Z, G, g, h);
+	element_clear(g);
+	element_clear(h);
+	if (!valid) goto invalid;
+	
+	if (u64_read(&num_secret, stream) != 8 || num_secret > PROOF_READ_MAX_VARS) goto invalid;
+	if (u64_read(&num_public, stream) != 8 || num_public > PROOF_READ_MAX_VARS) goto invalid;
+	proof->num_secret = num_secret;
+	proof->num_public = num_public;
+	
+	// Vectors must be non-empty, in order and disjoint.
+	if (u64_read(&count, stream) != 8) goto invalid;
+	for (i = 0, end = 0; i < count; i++) {
+		if (u64_read(&first, stream) != 8 || first < end || first >= num_secret) goto invalid;
+		if (u64_read(&length, stream) != 8 || length == 0 || length > (uint64_t)(INT_MAX / 8)) goto invalid;
+		if (length > num_secret - first) goto invalid;
+		_vector_add(proof, first, (int)length);
+		end = first + length;
 	}
-	for (i = 0; i < proof->num_public; i++) {
-		element_init(inst->public_values[i], proof->Z_type->field);
+	
+	if (u64_read(&count, stream) != 8) goto invalid;
+	for (i = 0; i < count; i++) {
+		if (u64_read(&kind, stream) != 8) goto invalid;
+		if (!computation_read(proof, (int)kind, stream)) goto invalid;
 	}
+	
+	if (u64_read(&count, stream) != 8) goto invalid;
+	for (i = 0; i < count; i++) {
+		if (u64_read(&kind, stream) != 8) goto invalid;
+		if (!block_read(proof, (int)kind, refs, stream)) goto invalid;
+	}
+	return 1;
+	
+invalid:
+	proof_clear(proof);
+	return 0;
+}
+
+// Points the arrays of an instance into a run of elements in the Z field and a run in
+// the G field, laid out as (public values, Z scratch, secret values, secret openings) and
+// (secret commitments, G scratch). The secret values and openings are only included for
+// a prover.
+void _inst_layout(proof_t proof, inst_t inst, element_t* Z_run, element_t* G_run, int prover) {
+	inst->public_values = Z_run;
+	inst->scratch_Z = Z_run + proof->num_public;
+	if (prover) {
+		inst->secret_values = inst->scratch_Z + INST_SCRATCH;
+		inst->secret_openings = inst->secret_values + proof->num_secret;
+	} else {
+		inst->secret_values = NULL;
+		inst->secret_openings = NULL;
+	}
+	inst->secret_commitments = G_run;
+	inst->scratch_G = G_run + proof->num_secret;
+}
+
+void _inst_init(proof_t proof, inst_t inst, int prover) {
+	long i;
+	long Z_count = proof->num_public + INST_SCRATCH + (prover ? 2 * proof->num_secret : 0);
+	long G_count = proof->num_secret + INST_SCRATCH;
+	element_t *run = pbc_malloc((Z_count + G_count) * sizeof(element_t) + proof->num_secret + proof->num_public);
+	for (i = 0; i < Z_count; i++) element_init(run[i], proof->Z_type->field);
+	for (i = 0; i < G_count; i++) element_init(run[Z_count + i], proof->G_type->field);
+	_inst_layout(proof, inst, run, run + Z_count, prover);
+	inst->dirty = (unsigned char*)(run + Z_count + G_count);
+	inst_invalidate(proof, inst);
+	inst->supplement_data = new((type_ptr)&proof->supplement_type);
+}
+
+void inst_init_prover(proof_t proof, inst_t inst) {
+	_inst_init(proof, inst, 1);
+}
+
+void inst_init_verifier(proof_t proof, inst_t inst) {
+	_inst_init(proof, inst, 0);
+}
+
+// The type of a dirty flag, which is initially set. Flags are never written or read.
+void _void_clear(type_ptr, data_ptr);
+void _void_write(type_ptr, data_ptr, FILE*);
+void _void_read(type_ptr, data_ptr, FILE*);
+size_t _void_read_bytes(type_ptr, data_ptr, const unsigned char*, size_t);
+void _flag_init(type_ptr type, data_ptr data) { *(unsigned char*)data = 1; }
+void _flag_copy(type_ptr type, data_ptr dest, data_ptr src) { *(unsigned char*)dest = *(unsigned char*)src; }
+type_t flag_type = {{
+	&_flag_init,
+	&_void_clear,
+	&_flag_copy,
+	&_void_write,
+	&_void_read,
+	&_void_read_bytes,
+	1
+}};
+
+void _inst_init_arena(proof_t proof, inst_t inst, arena_t arena, int prover) {
+	long Z_count = proof->num_public + INST_SCRATCH + (prover ? 2 * proof->num_secret : 0);
+	long G_count = proof->num_secret + INST_SCRATCH;
+	element_t *Z_run = (element_t*)arena_new_array(arena, (type_ptr)proof->Z_type, Z_count);
+	element_t *G_run = (element_t*)arena_new_array(arena, (type_ptr)proof->G_type, G_count);
+	_inst_layout(proof, inst, Z_run, G_run, prover);
+	inst->dirty = (unsigned char*)arena_new_array(arena, flag_type, proof->num_secret + proof->num_public);
+	inst->supplement_data = arena_new(arena, (type_ptr)&proof->supplement_type);
+}
+
+void inst_init_prover_arena(proof_t proof, inst_t inst, arena_t arena) {
+	_inst_init_arena(proof, inst, arena, 1);
+}
+
+void inst_init_verifier_arena(proof_t proof, inst_t inst, arena_t arena) {
+	_inst_init_arena(proof, inst, arena, 0);
 }
 
 void inst_clear(proof_t proof, inst_t inst) {
-	int i;
-	if (inst->secret_values != NULL) {
-		for (i = 0; i < proof->num_secret; i++) {
-			element_clear(inst->secret_values[i]);
-			element_clear(inst->secret_openings[i]);
-			element_clear(inst->secret_commitments[i]);
-		}
-		pbc_free(inst->secret_values);
-		pbc_free(inst->secret_openings);
+	long i;
+	long Z_count = proof->num_public + INST_SCRATCH + (inst->secret_values != NULL ? 2 * proof->num_secret : 0);
+	long G_count = proof->num_secret + INST_SCRATCH;
+	element_t *run = inst->public_values;
+	for (i = 0; i < Z_count + G_count; i++) element_clear(run[i]);
+	pbc_free(run);
+	delete((type_ptr)&proof->supplement_type, inst->supplement_data);
+}
+
+void inst_invalidate(proof_t proof, inst_t inst) {
+	memset(inst->dirty, VAR_DIRTY, proof->num_secret + proof->num_public);
+}
+
+void inst_var_assign(proof_t proof, inst_t inst, var_t var, element_t value) {
+	if (var_is_secret(var)) {
+		assert(inst->secret_values != NULL);
+		element_set(inst->secret_values[var_index(var)], value);
+		inst->dirty[var_dirty_index(proof, var)] |= VAR_DIRTY | VAR_STALE;
 	} else {
-		for (i = 0; i < proof->num_secret; i++) {
-			element_clear(inst->secret_commitments[i]);
+		element_set(inst->public_values[var_index(var)], value);
+		inst->dirty[var_dirty_index(proof, var)] |= VAR_DIRTY;
+	}
+}
+
+// Commits to the values of a vector in a prover instance with a new opening.
+void _vector_commit(proof_t proof, inst_t inst, secret_vector_ptr vector) {
+	int i; int count = vector->count;
+	element_ptr *bases = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (count + 1));
+	element_ptr *exps = (element_ptr*)pbc_malloc(sizeof(element_ptr) * (count + 1));
+	for (i = 0; i < count; i++) {
+		bases[i] = vector->generators[i];
+		exps[i] = inst->secret_values[vector->first + i];
+	}
+	element_random(inst->secret_openings[vector->first]);
+	bases[count] = proof->h;
+	exps[count] = inst->secret_openings[vector->first];
+	element_multi_pow(inst->secret_commitments[vector->first], count + 1, bases, exps); // V = h^o P^x
+	pbc_free(bases);
+	pbc_free(exps);
+}
+
+void inst_commit_stale(proof_t proof, inst_t inst) {
+	long i, j;
+	if (inst->secret_values == NULL) return;
+	
+	// A vector is committed to as a whole if any of its variables is stale, after which
+	// none of them are.
+	for (j = 0; j < proof->num_vectors; j++) {
+		secret_vector_ptr vector = &proof->vectors[j];
+		int stale = 0;
+		for (i = vector->first; i < vector->first + vector->count; i++) {
+			stale |= inst->dirty[i] & VAR_STALE;
+			inst->dirty[i] &= ~VAR_STALE;
 		}
+		if (stale) _vector_commit(proof, inst, vector);
 	}
-	pbc_free(inst->secret_commitments);
 	
-	for (i = 0; i < proof->num_public; i++) {
-		element_clear(inst->public_values[i]);
+	// Openings are drawn in order, then the commitments, which dominate the cost, are
+	// computed in parallel.
+	for (i = 0; i < proof->num_secret; i++) {
+		if (inst->dirty[i] & VAR_STALE) element_random(inst->secret_openings[i]);
+	}
+	#pragma omp parallel for schedule(dynamic)
+	for (i = 0; i < proof->num_secret; i++) {
+		if (inst->dirty[i] & VAR_STALE) {
+			proof_pow_gh(proof, inst->secret_commitments[i], // C_x = g^x h^(o_x)
+				inst->secret_values[i],
+				inst->secret_openings[i]);
+		}
 	}
-	pbc_free(inst->public_values);
-	delete((type_ptr)&proof->supplement_type, inst->supplement_data);
 }
 
 void update_secret_commitment(proof_t proof, inst_t inst, long index) {
+	if (proof->num_vectors > 0 && secret_vector_find(proof, index) >= 0) {
+		inst->dirty[index] |= VAR_STALE;
+		return;
+	}
 	element_random(inst->secret_openings[index]);
-	element_pow2_zn(inst->secret_commitments[index], // C_x = g^x h^(o_x)
-		proof->g, inst->secret_values[index],
-		proof->h, inst->secret_openings[index]);
+	proof_pow_gh(proof, inst->secret_commitments[index], // C_x = g^x h^(o_x)
+		inst->secret_values[index],
+		inst->secret_openings[index]);
 }
 
 void inst_var_set(proof_t proof, inst_t inst, var_t var, element_t value) {
+	inst->dirty[var_dirty_index(proof, var)] |= VAR_DIRTY;
 	if (var_is_secret(var)) {
 		assert(inst->secret_values != NULL);
 		element_set(inst->secret_values[var_index(var)], value);
@@ -159,6 +450,7 @@ void inst_var_set(proof_t proof, inst_t inst, var_t var, element_t value) {
 }
 
 void inst_var_set_mpz(proof_t proof, inst_t inst, var_t var, mpz_t value) {
+	inst->dirty[var_dirty_index(proof, var)] |= VAR_DIRTY;
 	if (var_is_secret(var)) {
 		assert(inst->secret_values != NULL);
 		element_set_mpz(inst->secret_values[var_index(var)], value);
@@ -169,6 +461,7 @@ void inst_var_set_mpz(proof_t proof, inst_t inst, var_t var, mpz_t value) {
 }
 
 void inst_var_set_si(proof_t proof, inst_t inst, var_t var, long int value) {
+	inst->dirty[var_dirty_index(proof, var)] |= VAR_DIRTY;
 	if (var_is_secret(var)) {
 		assert(inst->secret_values != NULL);
 		element_set_si(inst->secret_values[var_index(var)], value);
@@ -190,6 +483,7 @@ void inst_var_write(proof_t proof, inst_t inst, var_t var, FILE* stream) {
 }
 
 void inst_var_read(proof_t proof, inst_t inst, var_t var, FILE* stream) {
+	inst->dirty[var_dirty_index(proof, var)] |= VAR_DIRTY;
 	if (var_is_secret(var)) {
 		assert(inst->secret_values != NULL);
 		element_read(proof->Z_type->field, inst->secret_values[var_index(var)], stream);
@@ -204,15 +498,27 @@ data_ptr inst_supplement(proof_t proof, inst_t inst, supplement_t supplement) {
 }
 
 void inst_commitments_write(proof_t proof, inst_t inst, FILE* stream) {
-	int i;
+	long i;
 	for (i = 0; i < proof->num_secret; i++) {
+		if (!secret_committed(proof, i)) continue;
 		element_write(proof->G_type->field, inst->secret_commitments[i], stream);
 	}
 }
 
-void inst_commitments_read(proof_t proof, inst_t inst, FILE* stream) {
-	int i;
+void* alloca(size_t);
+int inst_commitments_read(proof_t proof, inst_t inst, FILE* stream) {
+	long i; uint32_t size; unsigned char *data;
+	if (proof->num_secret == 0) return 1;
+	
+	// Every commitment has the same size, so the length prefix is checked before the
+	// element is read and a corrupt stream can not ask for an arbitrarily large one.
+	size = element_length_in_bytes(inst->secret_commitments[0]);
+	data = (unsigned char*)alloca(4 + size);
 	for (i = 0; i < proof->num_secret; i++) {
-		element_read(proof->G_type->field, inst->secret_commitments[i], stream);
+		if (!secret_committed(proof, i)) continue;
+		if (fread(data, 1, 4 + size, stream) != 4 + size) return 0;
+		if (((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | (data[3] << 0)) != (int)size) return 0;
+		element_from_bytes(inst->secret_commitments[i], data + 4);
 	}
+	return 1;
 }
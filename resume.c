@@ -0,0 +1,73 @@
+#include <assert.h>
+#include <time.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_internal.h"
+#include "zkp_resume.h"
+
+// Gets the current time from the monotonic clock, in seconds.
+double _resume_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+void verifier_task_init(verifier_task_t task, proof_t proof, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response) {
+	assert(proof->plan != NULL);
+	task->proof = proof;
+	task->inst = inst;
+	task->claim_public = claim_public;
+	task->challenge = challenge;
+	task->response = response;
+	task->status = proof->num_blocks > 0 ? RESUME_PENDING : RESUME_VALID;
+	task->index = 0;
+	task->step = 0;
+	task->deadline = 0.0;
+	task->cancelled = 0;
+}
+
+void verifier_task_set_deadline(verifier_task_t task, double seconds) {
+	task->deadline = _resume_now() + seconds;
+}
+
+void verifier_task_cancel(verifier_task_t task) {
+	__atomic_store_n(&task->cancelled, 1, __ATOMIC_RELAXED);
+}
+
+int verifier_task_run(verifier_task_t task, int budget) {
+	proof_ptr proof = task->proof;
+	if (budget < 1) budget = 1;
+	while (task->status == RESUME_PENDING && budget-- > 0) {
+		if (__atomic_load_n(&task->cancelled, __ATOMIC_RELAXED)) {
+			task->status = RESUME_CANCELLED;
+			break;
+		}
+		if (task->deadline != 0.0 && _resume_now() > task->deadline) {
+			task->status = RESUME_EXPIRED;
+			break;
+		}
+		
+		plan_entry_ptr entry = &proof->plan[proof->plan_order[task->index]];
+		block_ptr block = entry->block;
+		data_ptr claim_public = get_block_part(entry, PART_CLAIM_PUBLIC, task->claim_public);
+		data_ptr response = get_block_part(entry, PART_RESPONSE, task->response);
+		int valid;
+		if (block->response_verify_step != NULL) {
+			valid = block->response_verify_step(block, proof, task->inst, claim_public, task->challenge, response, task->step);
+			task->step++;
+		} else {
+			valid = block->response_verify(block, proof, task->inst, claim_public, task->challenge, response);
+			task->step = block->verify_steps;
+		}
+		
+		if (!valid) {
+			task->status = RESUME_INVALID;
+		} else if (task->step >= block->verify_steps) {
+			task->step = 0;
+			if (++task->index == proof->num_blocks) task->status = RESUME_VALID;
+		}
+	}
+	return task->status;
+}
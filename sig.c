@@ -205,9 +205,12 @@ typedef struct block_sig_s {
 // [p, m_0, o_m_0, m_1, o_m_1, ...]  	= (Vs, Vq / Vx, C_m_0, C_m_1, ...)
 
 void _sig_clear(block_ptr);
+int _sig_write(block_ptr, proof_t, proof_refs_ptr, FILE*);
+void _sig_codegen(block_ptr, proof_t, codegen_ptr);
 void _sig_claim_gen(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
 void _sig_response_gen(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
 int _sig_response_verify(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+int _sig_response_verify_step(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr, int);
 block_sig_ptr block_sig_base(proof_t proof, sig_scheme_ptr scheme, data_ptr public_key) {
 	block_sig_ptr self = (block_sig_ptr)pbc_malloc(sizeof(block_sig_t));
 	array_type_init(self->message_type, (type_ptr)proof->Z_type, scheme->n * 2);
@@ -217,13 +220,19 @@ block_sig_ptr block_sig_base(proof_t proof, sig_scheme_ptr scheme, data_ptr publ
 	composite_type_init(self->claim_secret_type, 3, (type_ptr)scheme->Z_type, (type_ptr)scheme->sig_type, (type_ptr)self->Zx_type);
 	composite_type_init(self->claim_public_type, 3, (type_ptr)scheme->T_type, (type_ptr)scheme->sig_type, (type_ptr)self->Gx_type);
 	self->base->clear = &_sig_clear;
+	self->base->write = &_sig_write;
+	self->base->codegen = &_sig_codegen;
 	self->base->claim_gen = &_sig_claim_gen;
 	self->base->response_gen = &_sig_response_gen;
 	self->base->response_verify = &_sig_response_verify;
+	self->base->response_verify_batch = NULL;
+	self->base->response_verify_step = &_sig_response_verify_step;
+	self->base->verify_steps = 3 * scheme->n + 1;
 	self->base->supplement_type = (type_ptr)scheme->sig_type;
 	self->base->claim_secret_type = (type_ptr)self->claim_secret_type;
 	self->base->claim_public_type = (type_ptr)self->claim_public_type;
 	self->base->response_type = (type_ptr)self->Zx_type;
+	self->base->kind = BLOCK_SIG;
 	self->scheme = scheme;
 	self->public_key = public_key;
 	self->sig = proof->supplement_type.base->size;
@@ -242,6 +251,159 @@ void _sig_clear(block_ptr block) {
 	pbc_free(self);
 }
 
+int _sig_write(block_ptr block, proof_t proof, proof_refs_ptr refs, FILE* stream) {
+	block_sig_ptr self = (block_sig_ptr)block;
+	int i;
+	for (i = 0; i < refs->count; i++) {
+		if (refs->schemes[i] == self->scheme && refs->public_keys[i] == self->public_key) break;
+	}
+	if (i == refs->count) return 0;
+	u64_write(i, stream);
+	for (i = 0; i < self->scheme->n; i++) u64_write(self->indices[i], stream);
+	return 1;
+}
+
+int block_sig_read(proof_t proof, proof_refs_t refs, FILE* stream) {
+	int i; long ref;
+	if (!index_read(&ref, refs->count, stream)) return 0;
+	if (refs->schemes[ref]->n < 1) return 0;
+	block_sig_ptr self = block_sig_base(proof, refs->schemes[ref], refs->public_keys[ref]);
+	for (i = 0; i < self->scheme->n; i++) {
+		if (!secret_index_read(proof, &self->indices[i], stream)) return 0;
+	}
+	return 1;
+}
+
+sig_scheme_ptr block_sig_scheme(block_ptr block, data_ptr* public_key) {
+	block_sig_ptr self = (block_sig_ptr)block;
+	*public_key = self->public_key;
+	return self->scheme;
+}
+
+void _sig_codegen(block_ptr block, proof_t proof, codegen_ptr gen) {
+	block_sig_ptr self = (block_sig_ptr)block;
+	FILE* out = gen->stream;
+	int i; int n = self->scheme->n; int l = n - 1;
+	int b = gen->index;
+	
+	// Element indices within the claims, response and public key.
+	size_t cs = gen->base[PART_CLAIM_SECRET];
+	size_t cp = gen->base[PART_CLAIM_PUBLIC];
+	size_t rs = gen->base[PART_RESPONSE];
+	size_t cs_r_p = cs + 2 * n + 2, cs_r = cs_r_p + 1, cs_o_r = cs_r + n;
+	size_t cp_a = cp + 1, cp_b = cp + 2, cp_c = cp + 3, cp_A = cp + 4, cp_B = cp + 4 + l;
+	size_t cp_R_Vs = cp + 2 * n + 2, cp_R_Vq = cp_R_Vs + 1, cp_R = cp_R_Vq + 1;
+	size_t rs_x = rs + 1, rs_o_x = rs_x + n;
+	
+	if (gen->routine == CODEGEN_RESPONSE_GEN) {
+		if (gen->stage != CODEGEN_BODY) return;
+		fprintf(out, "\telement_mul(RS(%zu), challenge, CS(%zu));\n", rs, cs);
+		fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs, rs, cs_r_p);
+		for (i = 0; i < n; i++) {
+			fprintf(out, "\telement_mul(RS(%zu), challenge, SV(%ld));\n", rs_x + i, self->indices[i]);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs_x + i, rs_x + i, cs_r + i);
+			fprintf(out, "\telement_mul(RS(%zu), challenge, SO(%ld));\n", rs_o_x + i, self->indices[i]);
+			fprintf(out, "\telement_add(RS(%zu), RS(%zu), CS(%zu));\n", rs_o_x + i, rs_o_x + i, cs_o_r + i);
+		}
+		return;
+	}
+	
+	// The scheme, public key and pairing temporaries are looked up once per routine.
+	if (gen->stage == CODEGEN_DECLARE) {
+		fprintf(out, "\tdata_ptr pk_%d; sig_scheme_ptr scheme_%d = block_sig_scheme(proof->plan[%d].block, &pk_%d);\n", b, b, b, b);
+		fprintf(out, "\telement_t T_%d[3]; pairing_pp_t pp_%d;\n", b, b);
+		for (i = 0; i < 3; i++) fprintf(out, "\telement_init(T_%d[%d], scheme_%d->T_type->field);\n", b, i, b);
+		fprintf(out, "\tpairing_pp_init(pp_%d, E(pk_%d, 0), scheme_%d->pairing);\n", b, b, b);
+		return;
+	}
+	if (gen->stage == CODEGEN_CLEAR) {
+		for (i = 0; i < 3; i++) fprintf(out, "\telement_clear(T_%d[%d]);\n", b, i);
+		fprintf(out, "\tpairing_pp_clear(pp_%d);\n", b);
+		return;
+	}
+	
+	if (gen->routine == CODEGEN_CLAIM_GEN) {
+		
+		// Blind the signature by q, held in Z0, then raise c to p.
+		fprintf(out, "\telement_random(Z0);\n");
+		for (i = 0; i < 2 * n + 1; i++) {
+			fprintf(out, "\telement_pow_zn(CS(%zu), E(SUP(%zu), %d), Z0);\n", cs + 1 + i, self->sig, i);
+		}
+		fprintf(out, "\telement_random(CS(%zu));\n", cs);
+		fprintf(out, "\telement_pow_zn(CS(%zu), CS(%zu), CS(%zu));\n", cs + 3, cs + 3, cs);
+		for (i = 0; i < 2 * n + 1; i++) {
+			fprintf(out, "\telement_set(CP(%zu), CS(%zu));\n", cp + 1 + i, cs + 1 + i);
+		}
+		for (i = 0; i < n; i++) {
+			fprintf(out, "\telement_random(CS(%zu));\n", cs_r + i);
+			fprintf(out, "\telement_random(CS(%zu));\n", cs_o_r + i);
+			fprintf(out, "\tproof_pow_gh(proof, CP(%zu), CS(%zu), CS(%zu));\n", cp_R + i, cs_r + i, cs_o_r + i);
+		}
+		
+		// Vq and R_Vq from the pairings of X with a, b and B_#.
+		fprintf(out, "\tpairing_pp_apply(CP(%zu), CS(%zu), pp_%d);\n", cp, cs + 1, b);
+		fprintf(out, "\tpairing_pp_apply(T_%d[0], CS(%zu), pp_%d);\n", b, cs + 2, b);
+		fprintf(out, "\telement_pow_zn(CP(%zu), T_%d[0], CS(%zu));\n", cp_R_Vq, b, cs_r);
+		fprintf(out, "\telement_pow_zn(T_%d[0], T_%d[0], SV(%ld));\n", b, b, self->indices[0]);
+		fprintf(out, "\telement_mul(CP(%zu), CP(%zu), T_%d[0]);\n", cp, cp, b);
+		for (i = 0; i < l; i++) {
+			fprintf(out, "\tpairing_pp_apply(T_%d[0], CS(%zu), pp_%d);\n", b, cs + 4 + l + i, b);
+			fprintf(out, "\telement_pow_zn(T_%d[1], T_%d[0], CS(%zu));\n", b, b, cs_r + 1 + i);
+			fprintf(out, "\telement_mul(CP(%zu), CP(%zu), T_%d[1]);\n", cp_R_Vq, cp_R_Vq, b);
+			fprintf(out, "\telement_pow_zn(T_%d[0], T_%d[0], SV(%ld));\n", b, b, self->indices[1 + i]);
+			fprintf(out, "\telement_mul(CP(%zu), CP(%zu), T_%d[0]);\n", cp, cp, b);
+		}
+		fprintf(out, "\telement_random(CS(%zu));\n", cs_r_p);
+		fprintf(out, "\telement_pow_zn(CP(%zu), CP(%zu), CS(%zu));\n", cp_R_Vs, cp, cs_r_p);
+		return;
+	}
+	
+	// Commitments to the messages.
+	for (i = 0; i < n; i++) {
+		fprintf(out, "\tproof_pow_gh(proof, G0, RS(%zu), RS(%zu));\n", rs_x + i, rs_o_x + i);
+		fprintf(out, "\telement_pow_zn(G1, SC(%ld), challenge);\n", self->indices[i]);
+		fprintf(out, "\telement_mul(G1, G1, CP(%zu));\n", cp_R + i);
+		fprintf(out, "\tif (element_cmp(G0, G1)) goto invalid;\n");
+	}
+	
+	// Vq ^ x_p = Vs ^ e * R_Vs
+	fprintf(out, "\telement_pow_zn(T_%d[0], CP(%zu), RS(%zu));\n", b, cp, rs);
+	fprintf(out, "\tpairing_apply(T_%d[1], scheme_%d->g, CP(%zu), scheme_%d->pairing);\n", b, b, cp_c, b);
+	fprintf(out, "\telement_pow_zn(T_%d[1], T_%d[1], challenge);\n", b, b);
+	fprintf(out, "\telement_mul(T_%d[1], T_%d[1], CP(%zu));\n", b, b, cp_R_Vs);
+	fprintf(out, "\tif (element_cmp(T_%d[0], T_%d[1])) goto invalid;\n", b, b);
+	
+	// <Z_#, a> = <g, A_#>, <Y, a> = <g, b> and <Y, A_#> = <g, B_#>
+	for (i = 0; i < l; i++) {
+		fprintf(out, "\tpairing_apply(T_%d[0], E(pk_%d, %d), CP(%zu), scheme_%d->pairing);\n", b, b, 2 + i, cp_a, b);
+		fprintf(out, "\tpairing_apply(T_%d[1], scheme_%d->g, CP(%zu), scheme_%d->pairing);\n", b, b, cp_A + i, b);
+		fprintf(out, "\tif (element_cmp(T_%d[0], T_%d[1])) goto invalid;\n", b, b);
+	}
+	fprintf(out, "\tpairing_apply(T_%d[0], E(pk_%d, 1), CP(%zu), scheme_%d->pairing);\n", b, b, cp_a, b);
+	fprintf(out, "\tpairing_apply(T_%d[1], scheme_%d->g, CP(%zu), scheme_%d->pairing);\n", b, b, cp_b, b);
+	fprintf(out, "\tif (element_cmp(T_%d[0], T_%d[1])) goto invalid;\n", b, b);
+	for (i = 0; i < l; i++) {
+		fprintf(out, "\tpairing_apply(T_%d[0], E(pk_%d, 1), CP(%zu), scheme_%d->pairing);\n", b, b, cp_A + i, b);
+		fprintf(out, "\tpairing_apply(T_%d[1], scheme_%d->g, CP(%zu), scheme_%d->pairing);\n", b, b, cp_B + i, b);
+		fprintf(out, "\tif (element_cmp(T_%d[0], T_%d[1])) goto invalid;\n", b, b);
+	}
+	
+	// Vx ^ e * Vxy ^ x_0 * Vxy_1 ^ x_1 * ... = Vq ^ e * R_Vq
+	fprintf(out, "\tpairing_pp_apply(T_%d[0], CP(%zu), pp_%d);\n", b, cp_a, b);
+	fprintf(out, "\telement_pow_zn(T_%d[0], T_%d[0], challenge);\n", b, b);
+	fprintf(out, "\tpairing_pp_apply(T_%d[2], CP(%zu), pp_%d);\n", b, cp_b, b);
+	fprintf(out, "\telement_pow_zn(T_%d[2], T_%d[2], RS(%zu));\n", b, b, rs_x);
+	fprintf(out, "\telement_mul(T_%d[0], T_%d[0], T_%d[2]);\n", b, b, b);
+	for (i = 0; i < l; i++) {
+		fprintf(out, "\tpairing_pp_apply(T_%d[2], CP(%zu), pp_%d);\n", b, cp_B + i, b);
+		fprintf(out, "\telement_pow_zn(T_%d[2], T_%d[2], RS(%zu));\n", b, b, rs_x + 1 + i);
+		fprintf(out, "\telement_mul(T_%d[0], T_%d[0], T_%d[2]);\n", b, b, b);
+	}
+	fprintf(out, "\telement_pow_zn(T_%d[1], CP(%zu), challenge);\n", b, cp);
+	fprintf(out, "\telement_mul(T_%d[1], T_%d[1], CP(%zu));\n", b, b, cp_R_Vq);
+	fprintf(out, "\tif (element_cmp(T_%d[0], T_%d[1])) goto invalid;\n", b, b);
+}
+
 void _sig_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public) {
 	block_sig_ptr self = (block_sig_ptr)block;
 	sig_scheme_ptr scheme = self->scheme;
@@ -262,7 +424,7 @@ void _sig_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_
 	data_ptr R_message = get_part(self->Gx_type, Gx, 2);
 	
 	// Create a blinded signature by exponentiating all parts of the original signature by q.
-	element_t q; element_init(q, scheme->Z_type->field);
+	element_ptr q = inst->scratch_Z[0];
 	element_random(q);
 	for (i = 0; i < 2 * n + 1; i++) {
 		element_ptr To = get_element(scheme->G_type, get_item(scheme->sig_type, original_sig, i));
@@ -271,7 +433,6 @@ void _sig_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_
 		// Tb = To ^ q
 		element_pow_zn(Tb, To, q);
 	}
-	element_clear(q);
 	
 	// c := c ^ p
 	element_ptr c = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig_1, 2));
@@ -286,7 +447,7 @@ void _sig_claim_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_
 		element_ptr R = get_element(proof->G_type, get_item(self->message_commitment_type, R_message, i));
 		element_random(r);
 		element_random(o_r);
-		element_pow2_zn(R, proof->g, r, proof->h, o_r);
+		proof_pow_gh(proof, R, r, o_r);
 	}
 	
 	// Vq = Vx * Vxy ^ m_0 * Vxy_1 ^ m_1 * Vxy_2 ^ m_2 * ...
@@ -356,8 +517,12 @@ void _sig_response_gen(block_ptr block, proof_t proof, inst_t inst, data_ptr cla
 	}
 }
 
-int _sig_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
-	block_sig_ptr self = (block_sig_ptr)block;
+// Performs one of the 3n + 1 checks verifying a signature block, using the given
+// temporaries in the target group. The checks are, in order: the n message commitments,
+// Vs, the n - 1 pairings <Z_#, a> = <g, A_#>, <Y, a> = <g, b>, the n - 1 pairings
+// <Y, A_#> = <g, B_#>, and finally Vq.
+int _sig_check(block_sig_ptr self, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge,
+	data_ptr response, int step, element_t left_T, element_t right_T) {
 	sig_scheme_ptr scheme = self->scheme;
 	int i; int n = scheme->n; int l = n - 1;
 	element_ptr x_p = get_element(scheme->Z_type, get_part(self->Zx_type, response, 0));
@@ -368,72 +533,68 @@ int _sig_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr c
 	element_ptr R_Vs = get_element(scheme->T_type, get_part(self->Gx_type, Gx, 0));
 	element_ptr R_Vq = get_element(scheme->T_type, get_part(self->Gx_type, Gx, 1));
 	data_ptr R_message = get_part(self->Gx_type, Gx, 2);
+	element_ptr a = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 0));
+	element_ptr b = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 1));
+	element_ptr c = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 2));
+	element_ptr Y = get_element(scheme->G_type, get_item(scheme->public_key_type, self->public_key, 1));
 	
-	int result = 1;
-	element_t left_G; element_init(left_G, proof->G_type->field);
-	element_t right_G; element_init(right_G, proof->G_type->field);
-	element_t left_T; element_init(left_T, scheme->T_type->field);
-	element_t right_T; element_init(right_T, scheme->T_type->field);
-	
-	for (i = 0; i < n; i++) {
+	if (step < n) {
+		i = step;
+		element_ptr left_G = inst->scratch_G[0];
+		element_ptr right_G = inst->scratch_G[1];
 		element_ptr x = get_element(proof->Z_type, get_item(self->message_type, x_message, i));
 		element_ptr o_x = get_element(proof->Z_type, get_item(self->message_type, x_message, n + i));
 		element_ptr R = get_element(proof->G_type, get_item(self->message_commitment_type, R_message, i));
 		
 		// Verify g ^ x * h ^ o_x = C_m_# ^ e * R_#
-		element_pow2_zn(left_G, proof->g, x, proof->h, o_x);
+		proof_pow_gh(proof, left_G, x, o_x);
 		element_pow_zn(right_G, inst->secret_commitments[self->indices[i]], challenge);
 		element_mul(right_G, right_G, R);
-		if (element_cmp(left_G, right_G)) {
-			result = 0;
-			goto end;
-		}
+		return !element_cmp(left_G, right_G);
 	}
+	step -= n;
 	
-	// Verify Vq ^ x_p = Vs ^ e * R_Vs
-	element_ptr a = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 0));
-	element_ptr b = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 1));
-	element_ptr c = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 2));
-	element_pow_zn(left_T, Vq, x_p);
-	pairing_apply(right_T, scheme->g, c, scheme->pairing);
-	element_pow_zn(right_T, right_T, challenge);
-	element_mul(right_T, right_T, R_Vs);
-	if (element_cmp(left_T, right_T)) {
-		result = 0;
-		goto end;
+	if (step == 0) {
+		
+		// Verify Vq ^ x_p = Vs ^ e * R_Vs
+		element_pow_zn(left_T, Vq, x_p);
+		pairing_apply(right_T, scheme->g, c, scheme->pairing);
+		element_pow_zn(right_T, right_T, challenge);
+		element_mul(right_T, right_T, R_Vs);
+		return !element_cmp(left_T, right_T);
 	}
+	step -= 1;
 	
-	// Verify <Z_#, a> = <g, A_#>
-	for (i = 0; i < l; i++) {
+	if (step < l) {
+		i = step;
+		
+		// Verify <Z_#, a> = <g, A_#>
 		element_ptr Z = get_element(scheme->G_type, get_item(scheme->public_key_type, self->public_key, 2 + i));
 		element_ptr A = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 3 + i));
 		pairing_apply(left_T, Z, a, scheme->pairing);
 		pairing_apply(right_T, scheme->g, A, scheme->pairing);
-		if (element_cmp(left_T, right_T)) {
-			result = 0;
-			goto end;
-		}
+		return !element_cmp(left_T, right_T);
 	}
+	step -= l;
 	
-	// <Y, a> = <g, b>
-	element_ptr Y = get_element(scheme->G_type, get_item(scheme->public_key_type, self->public_key, 1));
-	pairing_apply(left_T, Y, a, scheme->pairing);
-	pairing_apply(right_T, scheme->g, b, scheme->pairing);
-	if (element_cmp(left_T, right_T)) {
-		result = 0;
-		goto end;
+	if (step == 0) {
+		
+		// <Y, a> = <g, b>
+		pairing_apply(left_T, Y, a, scheme->pairing);
+		pairing_apply(right_T, scheme->g, b, scheme->pairing);
+		return !element_cmp(left_T, right_T);
 	}
+	step -= 1;
 	
-	// <Y, A_#> = <g, B_#>
-	for (i = 0; i < l; i++) {
+	if (step < l) {
+		i = step;
+		
+		// <Y, A_#> = <g, B_#>
 		element_ptr A = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 3 + i));
 		element_ptr B = get_element(scheme->G_type, get_item(scheme->sig_type, blinded_sig, 3 + (n - 1) + i));
 		pairing_apply(left_T, Y, A, scheme->pairing);
 		pairing_apply(right_T, scheme->g, B, scheme->pairing);
-		if (element_cmp(left_T, right_T)) {
-			result = 0;
-			goto end;
-		}
+		return !element_cmp(left_T, right_T);
 	}
 	
 	// Verify Vx ^ e * Vxy ^ x_0 * Vxy_1 ^ x_1 * Vxy_2 ^ x_2 * ... = Vq ^ e * R_Vq
@@ -461,14 +622,32 @@ int _sig_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr c
 	
 	element_pow_zn(right_T, Vq, challenge);
 	element_mul(right_T, right_T, R_Vq);
-	if (element_cmp(left_T, right_T)) {
-		result = 0;
-		goto end;
+	return !element_cmp(left_T, right_T);
+}
+
+int _sig_response_verify(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response) {
+	block_sig_ptr self = (block_sig_ptr)block;
+	sig_scheme_ptr scheme = self->scheme;
+	int step; int result = 1;
+	element_t left_T; element_init(left_T, scheme->T_type->field);
+	element_t right_T; element_init(right_T, scheme->T_type->field);
+	for (step = 0; step < block->verify_steps; step++) {
+		if (!_sig_check(self, proof, inst, claim_public, challenge, response, step, left_T, right_T)) {
+			result = 0;
+			break;
+		}
 	}
-	
-end:
-	element_clear(left_G);
-	element_clear(right_G);
+	element_clear(left_T);
+	element_clear(right_T);
+	return result;
+}
+
+int _sig_response_verify_step(block_ptr block, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response, int step) {
+	block_sig_ptr self = (block_sig_ptr)block;
+	sig_scheme_ptr scheme = self->scheme;
+	element_t left_T; element_init(left_T, scheme->T_type->field);
+	element_t right_T; element_init(right_T, scheme->T_type->field);
+	int result = _sig_check(self, proof, inst, claim_public, challenge, response, step, left_T, right_T);
 	element_clear(left_T);
 	element_clear(right_T);
 	return result;
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_internal.h"
+#include "zkp_stream.h"
+
+void verifier_stream_init(verifier_stream_t stream, proof_t proof, inst_t inst, challenge_t challenge) {
+	stream->proof = proof;
+	stream->inst = inst;
+	stream->challenge = challenge;
+	stream->status = STREAM_PENDING;
+	stream->buffer_size = 0;
+	stream->buffer_capacity = 256;
+	stream->buffer = (unsigned char*)pbc_malloc(stream->buffer_capacity);
+	stream->claim_public = new((type_ptr)&proof->claim_public_type);
+	stream->current = proof->first_block;
+	stream->in_response = 0;
+	stream->claim_offset = 0;
+	stream->response = NULL;
+	stream->wanted = 0;
+	if (stream->current == NULL) stream->status = STREAM_VALID;
+}
+
+void verifier_stream_clear(verifier_stream_t stream) {
+	if (stream->response != NULL) delete(stream->current->response_type, stream->response);
+	delete((type_ptr)&stream->proof->claim_public_type, stream->claim_public);
+	pbc_free(stream->buffer);
+}
+
+// Returns the number of bytes a value takes when written.
+size_t _written_size(type_ptr type, data_ptr data) {
+	char *bytes; size_t size;
+	FILE* stream = open_memstream(&bytes, &size);
+	write(type, data, stream);
+	fclose(stream);
+	free(bytes);
+	return size;
+}
+
+// Parses as much of the buffered data as possible, returning the number of bytes consumed.
+// A claim or response is only parsed once as many bytes as it takes have arrived, so that
+// data arriving in small pieces is not parsed over and over.
+size_t _verifier_stream_parse(verifier_stream_t stream) {
+	proof_ptr proof = stream->proof;
+	size_t len = 0;
+	while (stream->current != NULL) {
+		block_ptr block = stream->current;
+		const unsigned char *bytes = stream->buffer + len;
+		size_t size = stream->buffer_size - len;
+		if (!stream->in_response) {
+		
+			// Parse the public claim for the current block.
+			data_ptr claim_public = (data_ptr)((char*)stream->claim_public + stream->claim_offset);
+			if (stream->wanted == 0) stream->wanted = _written_size(block->claim_public_type, claim_public);
+			if (size < stream->wanted) break;
+			size_t block_len = read_bytes(block->claim_public_type, claim_public, bytes, size);
+			if (block_len == READ_INCOMPLETE) break;
+			if (block_len == READ_ERROR) goto invalid;
+			len += block_len;
+			stream->wanted = 0;
+			stream->claim_offset += block->claim_public_type->size;
+			stream->current = block->next;
+			if (stream->current == NULL) {
+				stream->in_response = 1;
+				stream->claim_offset = 0;
+				stream->current = proof->first_block;
+			}
+		} else {
+		
+			// Parse the response for the current block, then verify it.
+			if (stream->response == NULL) stream->response = new(block->response_type);
+			if (stream->wanted == 0) stream->wanted = _written_size(block->response_type, stream->response);
+			if (size < stream->wanted) break;
+			size_t block_len = read_bytes(block->response_type, stream->response, bytes, size);
+			if (block_len == READ_INCOMPLETE) break;
+			if (block_len == READ_ERROR) goto invalid;
+			len += block_len;
+			stream->wanted = 0;
+			data_ptr claim_public = (data_ptr)((char*)stream->claim_public + stream->claim_offset);
+			int valid = block->response_verify(block, proof, stream->inst, claim_public, stream->challenge, stream->response);
+			delete(block->response_type, stream->response);
+			stream->response = NULL;
+			if (!valid) goto invalid;
+			stream->claim_offset += block->claim_public_type->size;
+			stream->current = block->next;
+			if (stream->current == NULL) stream->status = STREAM_VALID;
+		}
+	}
+	return len;
+	
+invalid:
+	if (stream->response != NULL) {
+		delete(stream->current->response_type, stream->response);
+		stream->response = NULL;
+	}
+	stream->current = NULL;
+	stream->status = STREAM_INVALID;
+	return len;
+}
+
+int verifier_stream_push(verifier_stream_t stream, const unsigned char* bytes, size_t size) {
+	if (stream->status != STREAM_PENDING) return stream->status;
+	
+	// Append to buffer.
+	if (stream->buffer_size + size > stream->buffer_capacity) {
+		while (stream->buffer_size + size > stream->buffer_capacity) stream->buffer_capacity *= 2;
+		stream->buffer = (unsigned char*)pbc_realloc(stream->buffer, stream->buffer_capacity);
+	}
+	memcpy(stream->buffer + stream->buffer_size, bytes, size);
+	stream->buffer_size += size;
+	
+	// Parse and drop consumed bytes.
+	size_t len = _verifier_stream_parse(stream);
+	memmove(stream->buffer, stream->buffer + len, stream->buffer_size - len);
+	stream->buffer_size -= len;
+	return stream->status;
+}
+
+void claim_gen_write(proof_t proof, inst_t inst, data_ptr claim_secret, FILE* stream) {
+	block_ptr current = proof->first_block;
+	while (current != NULL) {
+		data_ptr claim_public = new(current->claim_public_type);
+		current->claim_gen(current, proof, inst, claim_secret, claim_public);
+		write(current->claim_public_type, claim_public, stream);
+		delete(current->claim_public_type, claim_public);
+		claim_secret = (data_ptr)((char*)claim_secret + current->claim_secret_type->size);
+		current = current->next;
+	}
+}
+
+void response_gen_write(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, FILE* stream) {
+	block_ptr current = proof->first_block;
+	while (current != NULL) {
+		data_ptr response = new(current->response_type);
+		current->response_gen(current, proof, inst, claim_secret, challenge, response);
+		write(current->response_type, response, stream);
+		delete(current->response_type, response);
+		claim_secret = (data_ptr)((char*)claim_secret + current->claim_secret_type->size);
+		current = current->next;
+	}
+}
@@ -0,0 +1,182 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_transcript.h"
+
+// A cached transcript and the result of verifying it. The bytes of the transcript
+// follow the entry in the same allocation.
+typedef struct transcript_entry_s {
+	uint64_t hash;
+	int result;
+	size_t size;
+	struct transcript_entry_s *chain;
+	struct transcript_entry_s *prev;
+	struct transcript_entry_s *next;
+} transcript_entry_t;
+
+// The number of buckets a cache starts with.
+#define TRANSCRIPT_BUCKETS 64
+
+// Gets the bytes of the transcript for an entry.
+static inline unsigned char* _entry_bytes(transcript_entry_t *entry) {
+	return (unsigned char*)(entry + 1);
+}
+
+// Gets the number of bytes an entry counts against the memory limit of a cache.
+static inline size_t _entry_cost(transcript_entry_t *entry) {
+	return sizeof(transcript_entry_t) + entry->size;
+}
+
+// Serializes a transcript, returning a buffer that must be freed with free.
+unsigned char* _transcript_write(proof_t proof, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response, size_t* size) {
+	long i;
+	char *bytes;
+	FILE* stream = open_memstream(&bytes, size);
+	for (i = 0; i < proof->num_public; i++) {
+		element_write(proof->Z_type->field, inst->public_values[i], stream);
+	}
+	inst_commitments_write(proof, inst, stream);
+	write((type_ptr)&proof->claim_public_type, claim_public, stream);
+	element_write(proof->Z_type->field, challenge, stream);
+	write((type_ptr)&proof->response_type, response, stream);
+	fclose(stream);
+	return (unsigned char*)bytes;
+}
+
+// Removes an entry from the recently used list of a cache.
+void _entry_unlink(transcript_cache_t cache, transcript_entry_t *entry) {
+	if (entry->prev != NULL) entry->prev->next = entry->next;
+	else cache->newest = entry->next;
+	if (entry->next != NULL) entry->next->prev = entry->prev;
+	else cache->oldest = entry->prev;
+}
+
+// Inserts an entry at the front of the recently used list of a cache.
+void _entry_link(transcript_cache_t cache, transcript_entry_t *entry) {
+	entry->prev = NULL;
+	entry->next = cache->newest;
+	if (cache->newest != NULL) cache->newest->prev = entry;
+	else cache->oldest = entry;
+	cache->newest = entry;
+}
+
+// Removes the least recently used entry from a cache and frees it.
+void _cache_evict(transcript_cache_t cache) {
+	transcript_entry_t *entry = cache->oldest;
+	transcript_entry_t **link = &cache->buckets[entry->hash & (cache->num_buckets - 1)];
+	while (*link != entry) link = &(*link)->chain;
+	*link = entry->chain;
+	_entry_unlink(cache, entry);
+	cache->stats->count--;
+	cache->stats->bytes -= _entry_cost(entry);
+	cache->stats->evictions++;
+	pbc_free(entry);
+}
+
+// Doubles the number of buckets in a cache.
+void _cache_grow(transcript_cache_t cache) {
+	size_t i; size_t num_buckets = cache->num_buckets * 2;
+	transcript_entry_t **buckets = (transcript_entry_t**)pbc_malloc(sizeof(transcript_entry_t*) * num_buckets);
+	memset(buckets, 0, sizeof(transcript_entry_t*) * num_buckets);
+	for (i = 0; i < cache->num_buckets; i++) {
+		transcript_entry_t *entry = cache->buckets[i];
+		while (entry != NULL) {
+			transcript_entry_t *chain = entry->chain;
+			transcript_entry_t **bucket = &buckets[entry->hash & (num_buckets - 1)];
+			entry->chain = *bucket;
+			*bucket = entry;
+			entry = chain;
+		}
+	}
+	pbc_free(cache->buckets);
+	cache->buckets = buckets;
+	cache->num_buckets = num_buckets;
+}
+
+void transcript_cache_init(transcript_cache_t cache, proof_t proof, size_t max_bytes) {
+	assert(proof->plan != NULL);
+	cache->proof = proof;
+	cache->max_bytes = max_bytes;
+	cache->num_buckets = TRANSCRIPT_BUCKETS;
+	cache->buckets = (transcript_entry_t**)pbc_malloc(sizeof(transcript_entry_t*) * cache->num_buckets);
+	memset(cache->buckets, 0, sizeof(transcript_entry_t*) * cache->num_buckets);
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	memset(cache->stats, 0, sizeof(transcript_stats_t));
+	pthread_mutex_init(&cache->lock, NULL);
+}
+
+void transcript_cache_clear(transcript_cache_t cache) {
+	transcript_entry_t *entry = cache->newest;
+	while (entry != NULL) {
+		transcript_entry_t *next = entry->next;
+		pbc_free(entry);
+		entry = next;
+	}
+	pbc_free(cache->buckets);
+	pthread_mutex_destroy(&cache->lock);
+}
+
+int transcript_cache_verify(transcript_cache_t cache, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response) {
+	proof_ptr proof = cache->proof;
+	size_t size;
+	unsigned char *bytes = _transcript_write(proof, inst, claim_public, challenge, response, &size);
+	uint64_t hash = hash_bytes(bytes, size);
+	
+	// Look for an identical transcript.
+	pthread_mutex_lock(&cache->lock);
+	transcript_entry_t *entry = cache->buckets[hash & (cache->num_buckets - 1)];
+	while (entry != NULL && (entry->hash != hash || entry->size != size || memcmp(_entry_bytes(entry), bytes, size))) {
+		entry = entry->chain;
+	}
+	if (entry != NULL) {
+		int result = entry->result;
+		_entry_unlink(cache, entry);
+		_entry_link(cache, entry);
+		cache->stats->hits++;
+		pthread_mutex_unlock(&cache->lock);
+		free(bytes);
+		return result;
+	}
+	pthread_mutex_unlock(&cache->lock);
+	
+	// Verify without holding the lock, then insert the result. Another thread may have
+	// verified the same transcript meanwhile, in which case there will briefly be two
+	// entries for it; the older one is shadowed by the newer and is eventually evicted.
+	int result = response_verify(proof, inst, claim_public, challenge, response);
+	pthread_mutex_lock(&cache->lock);
+	cache->stats->misses++;
+	if (sizeof(transcript_entry_t) + size > cache->max_bytes) {
+		cache->stats->oversized++;
+	} else {
+		entry = (transcript_entry_t*)pbc_malloc(sizeof(transcript_entry_t) + size);
+		entry->hash = hash;
+		entry->result = result;
+		entry->size = size;
+		memcpy(_entry_bytes(entry), bytes, size);
+		while (cache->stats->bytes + _entry_cost(entry) > cache->max_bytes) _cache_evict(cache);
+		if (cache->stats->count >= cache->num_buckets) _cache_grow(cache);
+		transcript_entry_t **bucket = &cache->buckets[hash & (cache->num_buckets - 1)];
+		entry->chain = *bucket;
+		*bucket = entry;
+		_entry_link(cache, entry);
+		cache->stats->count++;
+		cache->stats->bytes += _entry_cost(entry);
+	}
+	pthread_mutex_unlock(&cache->lock);
+	free(bytes);
+	return result;
+}
+
+void transcript_cache_stats(transcript_cache_t cache, transcript_stats_t stats) {
+	pthread_mutex_lock(&cache->lock);
+	memcpy(stats, cache->stats, sizeof(transcript_stats_t));
+	pthread_mutex_unlock(&cache->lock);
+}
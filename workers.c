@@ -0,0 +1,191 @@
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <pbc.h>
+#include "zkp_io.h"
+#include "zkp_proof.h"
+#include "zkp_workers.h"
+
+// A worker thread and its queue, a growable ring of jobs. The owner pushes and pops at
+// the bottom, and other workers steal from the top. The ends only ever grow and are taken
+// modulo the capacity, so they are 64-bit to never wrap.
+typedef struct worker_s {
+	pthread_t thread;
+	workers_ptr workers;
+	int index;
+	pthread_mutex_t lock;
+	verify_job_ptr *jobs;
+	int capacity;
+	uint64_t top;
+	uint64_t bottom;
+} worker_t;
+
+// The worker running on the current thread, if any.
+static __thread worker_t *worker_current = NULL;
+
+void _worker_push(worker_t *worker, verify_job_ptr job) {
+	pthread_mutex_lock(&worker->lock);
+	if (worker->bottom - worker->top == (uint64_t)worker->capacity) {
+		uint64_t i; int capacity = worker->capacity * 2;
+		verify_job_ptr *jobs = (verify_job_ptr*)pbc_malloc(sizeof(verify_job_ptr) * capacity);
+		for (i = worker->top; i < worker->bottom; i++) jobs[i % capacity] = worker->jobs[i % worker->capacity];
+		pbc_free(worker->jobs);
+		worker->jobs = jobs;
+		worker->capacity = capacity;
+	}
+	worker->jobs[worker->bottom++ % worker->capacity] = job;
+	pthread_mutex_unlock(&worker->lock);
+}
+
+verify_job_ptr _worker_pop(worker_t *worker) {
+	verify_job_ptr job = NULL;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->bottom > worker->top) job = worker->jobs[--worker->bottom % worker->capacity];
+	pthread_mutex_unlock(&worker->lock);
+	return job;
+}
+
+verify_job_ptr _worker_steal(worker_t *worker) {
+	verify_job_ptr job = NULL;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->bottom > worker->top) job = worker->jobs[worker->top++ % worker->capacity];
+	pthread_mutex_unlock(&worker->lock);
+	return job;
+}
+
+// Finds a job for a worker, from its own queue or another's.
+verify_job_ptr _worker_find(worker_t *worker) {
+	int i; workers_ptr workers = worker->workers;
+	verify_job_ptr job = _worker_pop(worker);
+	for (i = 1; job == NULL && i < workers->count; i++) {
+		job = _worker_steal(&workers->workers[(worker->index + i) % workers->count]);
+	}
+	return job;
+}
+
+void* _worker_run(void* arg) {
+	worker_t *worker = (worker_t*)arg;
+	workers_ptr workers = worker->workers;
+	worker_current = worker;
+	for (;;) {
+		pthread_mutex_lock(&workers->lock);
+		while (workers->queued == 0 && !workers->stopping) pthread_cond_wait(&workers->work_cond, &workers->lock);
+		if (workers->queued == 0) {
+			pthread_mutex_unlock(&workers->lock);
+			break;
+		}
+		workers->queued--;
+		pthread_mutex_unlock(&workers->lock);
+		
+		// A job is queued somewhere, and no other worker can claim it once it has been
+		// counted, so keep looking until it is found.
+		verify_job_ptr job;
+		while ((job = _worker_find(worker)) == NULL) sched_yield();
+		
+		job->result = response_verify(job->proof, job->inst, job->claim_public, job->challenge, job->response);
+		if (job->callback != NULL) job->callback(job, job->arg);
+		pthread_mutex_lock(&workers->lock);
+		job->done = 1;
+		workers->pending--;
+		pthread_cond_broadcast(&workers->done_cond);
+		pthread_mutex_unlock(&workers->lock);
+	}
+	return NULL;
+}
+
+void verify_job_init(verify_job_t job, proof_t proof, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response, void (*callback)(verify_job_ptr, void*), void* arg) {
+	job->proof = proof;
+	job->inst = inst;
+	job->claim_public = claim_public;
+	job->challenge = challenge;
+	job->response = response;
+	job->callback = callback;
+	job->arg = arg;
+	job->result = 0;
+	job->done = 0;
+	job->workers = NULL;
+}
+
+int verify_job_wait(verify_job_t job) {
+	workers_ptr workers = job->workers;
+	pthread_mutex_lock(&workers->lock);
+	while (!job->done) pthread_cond_wait(&workers->done_cond, &workers->lock);
+	pthread_mutex_unlock(&workers->lock);
+	return job->result;
+}
+
+void workers_init(workers_t workers, int count) {
+	int i;
+	workers->count = count;
+	workers->next = 0;
+	workers->pending = 0;
+	workers->queued = 0;
+	workers->stopping = 0;
+	pthread_mutex_init(&workers->lock, NULL);
+	pthread_cond_init(&workers->work_cond, NULL);
+	pthread_cond_init(&workers->done_cond, NULL);
+	workers->workers = (worker_t*)pbc_malloc(sizeof(worker_t) * count);
+	for (i = 0; i < count; i++) {
+		worker_t *worker = &workers->workers[i];
+		worker->workers = workers;
+		worker->index = i;
+		pthread_mutex_init(&worker->lock, NULL);
+		worker->capacity = 16;
+		worker->jobs = (verify_job_ptr*)pbc_malloc(sizeof(verify_job_ptr) * worker->capacity);
+		worker->top = 0;
+		worker->bottom = 0;
+	}
+	for (i = 0; i < count; i++) {
+		pthread_create(&workers->workers[i].thread, NULL, &_worker_run, &workers->workers[i]);
+	}
+}
+
+void workers_clear(workers_t workers) {
+	int i;
+	workers_wait(workers);
+	pthread_mutex_lock(&workers->lock);
+	workers->stopping = 1;
+	pthread_cond_broadcast(&workers->work_cond);
+	pthread_mutex_unlock(&workers->lock);
+	for (i = 0; i < workers->count; i++) {
+		pthread_join(workers->workers[i].thread, NULL);
+		pthread_mutex_destroy(&workers->workers[i].lock);
+		pbc_free(workers->workers[i].jobs);
+	}
+	pbc_free(workers->workers);
+	pthread_mutex_destroy(&workers->lock);
+	pthread_cond_destroy(&workers->work_cond);
+	pthread_cond_destroy(&workers->done_cond);
+}
+
+void workers_submit(workers_t workers, verify_job_t job) {
+	worker_t *worker;
+	assert(job->proof->plan != NULL);
+	job->workers = workers;
+	job->done = 0;
+	
+	// Jobs submitted from a worker (such as from a callback) stay on its own queue.
+	if (worker_current != NULL && worker_current->workers == workers) {
+		worker = worker_current;
+	} else {
+		pthread_mutex_lock(&workers->lock);
+		worker = &workers->workers[workers->next];
+		workers->next = (workers->next + 1) % workers->count;
+		pthread_mutex_unlock(&workers->lock);
+	}
+	_worker_push(worker, job);
+	
+	pthread_mutex_lock(&workers->lock);
+	workers->pending++;
+	workers->queued++;
+	pthread_cond_signal(&workers->work_cond);
+	pthread_mutex_unlock(&workers->lock);
+}
+
+void workers_wait(workers_t workers) {
+	pthread_mutex_lock(&workers->lock);
+	while (workers->pending > 0) pthread_cond_wait(&workers->done_cond, &workers->lock);
+	pthread_mutex_unlock(&workers->lock);
+}
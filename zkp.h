@@ -5,5 +5,17 @@
 #include "zkp_io.h"
 #include "zkp_sig.h"
 #include "zkp_proof.h"
+#include "zkp_arena.h"
+#include "zkp_archive.h"
+#include "zkp_stream.h"
+#include "zkp_batch.h"
+#include "zkp_precomp.h"
+#include "zkp_codegen.h"
+#include "zkp_pool.h"
+#include "zkp_workers.h"
+#include "zkp_resume.h"
+#include "zkp_transcript.h"
+#include "zkp_member.h"
+#include "zkp_accumulator.h"
 
 #endif // ZKP_H_
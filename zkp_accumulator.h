@@ -0,0 +1,102 @@
+#ifndef ZKP_ACCUMULATOR_H_
+#define ZKP_ACCUMULATOR_H_
+
+// A pairing-based dynamic accumulator, which represents a set of values as a single group
+// element V = g ^ ((s + y_0) * (s + y_1) * ...) for a trapdoor s known only to its owner.
+// A witness for a value y is W = V ^ (1 / (s + y)), which anyone may check against the
+// public key P = g ^ s with <W, P * g ^ y> = <V, g>. Unlike a member set, values may be
+// removed, and each change is published as an update record from which holders bring
+// their witnesses up to date without the owner's help.
+//
+// The accumulator is built on a signature scheme that signs no values, whose key pair
+// [s] and [P] is the trapdoor and public key of the accumulator.
+typedef struct accumulator_s *accumulator_ptr;
+typedef struct accumulator_s {
+
+	// The signature scheme providing the pairing, types and key pair of the accumulator.
+	sig_scheme_t scheme;
+
+	// The secret key of the accumulator, or NULL if it was read from its published form.
+	data_ptr secret_key;
+
+	// The public key of the accumulator.
+	data_ptr public_key;
+
+	// The current value of the accumulator.
+	element_t value;
+
+} accumulator_t[1];
+
+// Describes a single change to an accumulator: the value that was added or removed, and
+// the value of the accumulator after the change.
+typedef struct accumulator_update_s *accumulator_update_ptr;
+typedef struct accumulator_update_s {
+	int removed;
+	element_t value;
+	element_t result;
+} accumulator_update_t[1];
+
+// Initializes an empty accumulator with a new trapdoor.
+void accumulator_init(accumulator_t acc, pairing_ptr pairing, element_t g);
+
+// Frees the space occupied by an accumulator.
+void accumulator_clear(accumulator_t acc);
+
+// Adds values to an accumulator. The accumulator must have its secret key. If updates is
+// not NULL, it receives one (newly initialized) record for each value; otherwise the
+// values are added with a single exponentiation.
+void accumulator_add(accumulator_t acc, element_t value, accumulator_update_ptr update);
+void accumulator_add_many(accumulator_t acc, int count, element_t* values, accumulator_update_t* updates);
+
+// Removes values from an accumulator, as accumulator_add adds them.
+void accumulator_remove(accumulator_t acc, element_t value, accumulator_update_ptr update);
+void accumulator_remove_many(accumulator_t acc, int count, element_t* values, accumulator_update_t* updates);
+
+// Frees the space occupied by an update record.
+void accumulator_update_clear(accumulator_update_t update);
+
+// Writes an update record to a stream.
+void accumulator_update_write(accumulator_t acc, accumulator_update_t update, FILE* stream);
+
+// Initializes an update record from a stream. Returns zero if the data is malformed, in
+// which case the record is left cleared.
+int accumulator_update_read(accumulator_t acc, accumulator_update_t update, FILE* stream);
+
+// Sets the value of an accumulator to its value after the given updates, which must
+// follow on from its current value. This is how a published copy keeps up with its owner.
+void accumulator_apply(accumulator_t acc, int count, accumulator_update_t* updates);
+
+// Computes the witness for a value in an accumulator. The accumulator must have its
+// secret key, and the value should have been added to it.
+void accumulator_witness(accumulator_t acc, element_t witness, element_t value);
+
+// Brings the witness for a value up to date with the given updates, which must follow on
+// from the current value of the accumulator, so this must be called before
+// accumulator_apply. All updates are folded into a single multi-exponentiation. Returns
+// zero if one of the updates removes the value, in which case the witness is unchanged.
+int accumulator_update_witness(accumulator_t acc, element_t witness, element_t value,
+	int count, accumulator_update_t* updates);
+
+// Verifies that a witness shows a value is in an accumulator. Returns a non-zero value
+// if it does.
+int accumulator_verify(accumulator_t acc, element_t witness, element_t value);
+
+// Writes the published form of an accumulator (its public key and value) to a stream.
+void accumulator_write(accumulator_t acc, FILE* stream);
+
+// Initializes an accumulator from its published form, without a secret key. Returns zero
+// if the data is malformed, in which case the accumulator is left cleared.
+int accumulator_read(accumulator_t acc, pairing_ptr pairing, element_t g, FILE* stream);
+
+// Requires that a variable is one of the values of an accumulator in the given proof.
+// The supplement (a G1 element) must be filled with the witness for the value for each
+// prover instance. Proving and verifying use the value the accumulator had when the
+// block was built (or read), so later changes to the accumulator do not affect a
+// finalized proof. After an update, the proof (and any transcript cache for it) must be
+// built or read again to prove membership in the new set. The claim, response and
+// verification are of constant size, however many values the accumulator holds. To
+// serialize the proof, the accumulator must be in the accumulators of the references
+// table.
+void require_accumulated(proof_t proof, accumulator_t acc, supplement_t* witness, var_t var);
+
+#endif // ZKP_ACCUMULATOR_H_
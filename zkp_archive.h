@@ -0,0 +1,79 @@
+#ifndef ZKP_ARCHIVE_H_
+#define ZKP_ARCHIVE_H_
+
+#include <stdint.h>
+
+// An archive is a file holding any number of proof records for a single proof. It
+// begins with a fixed-size header, followed by the records, followed by an index of
+// record offsets. Each record holds a challenge, the public values and commitments of
+// an instance, the public claim and the response, in the same format written by
+// element_write. Records can be read in any order directly from a memory-mapped archive.
+
+// The size of the header at the start of an archive.
+#define ARCHIVE_HEADER_SIZE 32
+
+// The size of an entry in the index of an archive.
+#define ARCHIVE_INDEX_ENTRY_SIZE 16
+
+// Writes proof records to an archive.
+typedef struct archive_writer_s *archive_writer_ptr;
+typedef struct archive_writer_s {
+	
+	// The stream the archive is written to. This must be seekable.
+	FILE* stream;
+	
+	// The position of the start of the archive in the stream.
+	off_t start;
+	
+	// The number of records that have been written.
+	uint64_t count;
+	
+	// The number of records the index has room for.
+	uint64_t capacity;
+	
+	// The offset and size of each record that has been written.
+	uint64_t *index;
+	
+} archive_writer_t[1];
+
+// Begins writing an archive at the current position of the given stream.
+void archive_writer_init(archive_writer_t writer, FILE* stream);
+
+// Writes a record for an instance of a proof and a response to the given challenge.
+void archive_writer_add(archive_writer_t writer, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response);
+
+// Writes the index and header for an archive and frees the space occupied by the writer.
+// The stream is left open.
+void archive_writer_clear(archive_writer_t writer);
+
+// A memory-mapped archive opened for reading.
+typedef struct archive_s *archive_ptr;
+typedef struct archive_s {
+	
+	// The contents of the archive.
+	const unsigned char *data;
+	
+	// The size of the archive in bytes.
+	size_t size;
+	
+	// The number of records in the archive.
+	uint64_t count;
+	
+	// The index of the archive, within data.
+	const unsigned char *index;
+	
+} archive_t[1];
+
+// Opens an archive from the file with the given path. Returns zero if the file can
+// not be mapped or is not a valid archive.
+int archive_open(archive_t archive, const char* path);
+
+// Closes an archive, unmapping its contents.
+void archive_close(archive_t archive);
+
+// Reads a record from an archive into a verifier instance, a public claim, a challenge and
+// a response. Computed variables should be restored with inst_update afterwards. Returns
+// zero if the record is malformed, including when bytes remain after the response.
+int archive_read(archive_t archive, uint64_t record, proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response);
+
+#endif // ZKP_ARCHIVE_H_
@@ -0,0 +1,52 @@
+#ifndef ZKP_ARENA_H_
+#define ZKP_ARENA_H_
+
+// A reusable region for the instances, claims and responses of a proof. Data is
+// allocated from large chunks and initialized once; resetting the arena keeps every
+// allocation initialized, and the same sequence of allocations after a reset returns
+// the same data without allocating or initializing anything. Data handed out after a
+// reset still holds the values it had before, so it must be fully set before it is
+// read. If the sequence of allocations changes, data from the first difference onwards
+// is cleared and allocated again.
+typedef struct arena_s *arena_ptr;
+typedef struct arena_s {
+	
+	// The minimum size of each chunk.
+	size_t chunk_size;
+	
+	// The chunks of the arena, in allocation order, and the chunk currently allocated from.
+	struct arena_chunk_s *first_chunk;
+	struct arena_chunk_s *current_chunk;
+	
+	// The allocations made from the arena, in order.
+	struct arena_entry_s *entries;
+	int count;
+	int capacity;
+	
+	// The index of the entry that the next allocation will try to reuse.
+	int next;
+	
+} arena_t[1];
+
+// Initializes an arena which allocates chunks of at least the given size.
+void arena_init(arena_t arena, size_t chunk_size);
+
+// Clears all data allocated from an arena and frees its space.
+void arena_clear(arena_t arena);
+
+// Makes all data allocated from an arena available for reuse, without clearing it.
+void arena_reset(arena_t arena);
+
+// Allocates initialized data of the given type from an arena.
+data_ptr arena_new(arena_t arena, type_ptr type);
+
+// Allocates an initialized array of data of the given type from an arena.
+data_ptr arena_new_array(arena_t arena, type_ptr type, size_t count);
+
+// Initializes an instance of a proof with all of its data allocated from an arena. The
+// instance remains valid until the arena is reset or cleared, and must not be passed to
+// inst_clear.
+void inst_init_prover_arena(proof_t proof, inst_t inst, arena_t arena);
+void inst_init_verifier_arena(proof_t proof, inst_t inst, arena_t arena);
+
+#endif // ZKP_ARENA_H_
@@ -0,0 +1,57 @@
+#ifndef ZKP_BATCH_H_
+#define ZKP_BATCH_H_
+
+// The verifier values of many instances of the same finalized proof, stored with one
+// array per variable holding that variable for every instance (structure of arrays), so
+// that each block can be verified across all instances in one pass with its metadata
+// resolved once. Blocks without a batched verifier are verified one instance at a time
+// through a view of the instance.
+typedef struct batch_s *batch_ptr;
+typedef struct batch_s {
+	
+	// The proof the instances are for.
+	proof_ptr proof;
+	
+	// The number of instances.
+	int count;
+	
+	// The commitments for each secret variable, each an array with one per instance.
+	element_t **secret_commitments;
+	
+	// The values of each public variable, each an array with one per instance.
+	element_t **public_values;
+	
+	// The challenge for each instance.
+	element_t *challenges;
+	
+	// Temporaries for blocks to use while verifying.
+	element_t *scratch_Z;
+	element_t *scratch_G;
+	
+	// An instance used to verify blocks without a batched verifier, which refers to the
+	// values of one instance at a time.
+	struct inst_s view;
+	
+} batch_t[1];
+
+// Initializes storage for a number of verifier instances of a finalized proof.
+void batch_init(batch_t batch, proof_t proof, int count);
+
+// Frees the space occupied by a batch.
+void batch_clear(batch_t batch);
+
+// Copies the commitments and public values of a verifier instance into a batch.
+void batch_set_inst(batch_t batch, int index, inst_t inst);
+
+// Gets the commitment of a secret variable, the value of a public variable, or the
+// challenge, of one instance in a batch.
+element_ptr batch_commitment(batch_t batch, int index, var_t var);
+element_ptr batch_public(batch_t batch, int index, var_t var);
+element_ptr batch_challenge(batch_t batch, int index);
+
+// Verifies the public claims and responses of all instances in a batch against their
+// challenges, setting valid[i] to zero if instance i is invalid and non-zero otherwise.
+// Returns the number of valid instances.
+int batch_verify(batch_t batch, data_ptr* claim_public, data_ptr* response, int* valid);
+
+#endif // ZKP_BATCH_H_
@@ -0,0 +1,25 @@
+#ifndef ZKP_CODEGEN_H_
+#define ZKP_CODEGEN_H_
+
+// Writes C source for a prover and verifier specialized to a finalized proof. The source
+// defines the following functions, where <name> is the given name (which must be a valid
+// C identifier):
+//
+//	int <name>_check(proof_t proof, proof_refs_t refs);
+//	void <name>_claim_gen(proof_t proof, inst_t inst, data_ptr claim_secret, data_ptr claim_public);
+//	void <name>_response_gen(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, data_ptr response);
+//	int <name>_response_verify(proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response);
+//
+// The last three are drop-in replacements for claim_gen, response_gen and response_verify
+// on the same statement, with variable indices and data offsets fixed, loops unrolled and
+// temporaries allocated once per call. Blocks that cannot be specialized are called through
+// the plan of the proof. The check function returns zero if a proof does not have the
+// layout the source was generated for, or describes a different statement (compared by
+// proof_digest, so the commitment bases must also match), and should be used to guard
+// the generated functions when the proof is built or read at run time. The references
+// table is used to describe the proof, as for proof_write. The source must be compiled
+// against the internal headers of this library. Returns zero if the proof can not be
+// described with the given references or the stream fails.
+int proof_codegen(proof_t proof, proof_refs_t refs, const char* name, FILE* stream);
+
+#endif // ZKP_CODEGEN_H_
@@ -10,31 +10,118 @@ int mpz_decompose_prime(mpz_t a, mpz_t b, mpz_t n);
 // Finds four non-negative integers whose squares su to the given 
 // non-negative integer. This is always possible due to the
 // Lagrange four square theorem.
+//
+// No block calls these: over the field Zr every value is a sum of four
+// squares, so they can not bound a variable there, and require_range
+// decomposes into bits instead. They are the witness generator for range
+// arguments over integer commitments, where the squares do prove that a
+// value is non-negative; bench_decompose.c measures them.
 void mpz_decompose(mpz_t a, mpz_t b, mpz_t c, mpz_t d, mpz_t n);
 
+// Computes the product of bases[#] ^ exps[#], combining a few bases three at a time and
+// many by the bucket method. The output may not be one of the bases.
+void element_multi_pow(element_t out, int count, element_ptr* bases, element_ptr* exps);
+
+// Derives an element by hashing a label and an index, so that no relation between the
+// elements derived for different labels and indices (or any other elements) is known.
+void element_from_label(element_t out, const char* label, uint64_t index);
+
+// Computes g ^ a * h ^ b for the g and h elements of a proof.
+void proof_pow_gh(proof_t proof, element_t out, element_t a, element_t b);
+
+// Computes h ^ b for the h element of a proof.
+void proof_pow_h(proof_t proof, element_t out, element_t b);
+
 // Gets the index for the given variable.
 long var_index(var_t var);
 
+// Indicates whether the given variable has been declared in the given proof.
+int var_valid(proof_t proof, var_t var);
+
 // Returns a variable index for a secret variable that is equivalent to the given
 // variable.
 long var_secret_index(proof_t proof, var_t var);
 
+// Reads a variable index from a stream, returning zero if it is not below the given count.
+int index_read(long* index, long count, FILE* stream);
+
+// Reads the index of a secret variable from a stream like index_read, also returning zero
+// if it is a member of a vector, since vector members have no commitment of their own.
+int secret_index_read(proof_t proof, long* index, FILE* stream);
+
+// A vector of consecutive secret variables, committed to with V = h ^ o * P_0 ^ x_0 * ...
+// over generators derived by hashing the index of the vector. There are size generators,
+// count padded up to a power of two, so that inner-product arguments can use them.
+typedef struct secret_vector_s {
+	long first;
+	int count;
+	int size;
+	element_t *generators;
+} secret_vector_t;
+
+// Returns the index of the vector that contains the given secret variable, or -1 if the
+// variable has a commitment of its own.
+long secret_vector_find(proof_t proof, long index);
+
+// Indicates whether the commitment of the given secret variable is sent to the verifier,
+// which is the case unless it belongs to a vector and is not its first variable.
+int secret_committed(proof_t proof, long index);
+
+// Identifies the kind of a computation in a serialized proof.
+enum computation_kind {
+	COMPUTATION_SET,
+	COMPUTATION_MOV,
+	COMPUTATION_BITS
+};
+
 // A computational procedure for a proof that calculates the values of a subset of
-// instance variables.
+// instance variables (its outputs) from others (its inputs).
 typedef struct computation_s *computation_ptr;
 typedef struct computation_s {
 	void (*clear)(computation_ptr);
 	void (*apply)(computation_ptr, proof_t, inst_t);
+	void (*write)(computation_ptr, proof_t, FILE*);
+	int kind;
 	int is_secret;
+	int num_inputs;
+	var_t *inputs;
+	int num_outputs;
+	var_t *outputs;
 	computation_ptr next;
 } computation_t[1];
 
+// The flags kept for each variable of an instance. A variable is dirty if it has changed
+// since the last update, and stale if it is secret and its commitment has not been
+// recomputed since it changed.
+#define VAR_DIRTY 1
+#define VAR_STALE 2
+
+// Sets the value of a variable in an instance from a computation. Unlike inst_var_set,
+// this does not commit to a secret value; it marks it stale, and inst_commit_stale
+// commits to it once all computations have run.
+void inst_var_assign(proof_t proof, inst_t inst, var_t var, element_t value);
+
+// Commits to the values of all stale secret variables in an instance.
+void inst_commit_stale(proof_t proof, inst_t inst);
+
+// Gets the index of the dirty flag for a variable in an instance.
+static inline long var_dirty_index(proof_t proof, var_t var) {
+	return var_is_secret(var) ? var_index(var) : proof->num_secret + var_index(var);
+}
+
 // Inserts a computation into a proof.
 void computation_insert(proof_t proof, computation_ptr computation);
 
 // Clears all computations in a proof.
 void computations_clear(proof_t proof);
 
+// Orders the computations of a proof into levels of independent computations.
+void computations_finalize(proof_t proof);
+
+// Reads a computation of the given kind from a stream and inserts it into a proof. Returns
+// zero if it is malformed.
+int computation_read(proof_t proof, int kind, FILE* stream);
+
 // Inserts a computation into a proof that assigns a constant value to a variable.
 void computation_set(proof_t proof, var_t var, element_t value);
 void computation_set_mpz(proof_t proof, var_t var, mpz_t value);
@@ -43,30 +130,150 @@ void computation_set_si(proof_t proof, var_t var, long int value);
 // Inserts a computation into a proof that assigns one variable to another.
 void computation_mov(proof_t proof, var_t dest, var_t src);
 
+// The largest number of bits a value may be decomposed into, so that the weight of every
+// bit fits in a long coefficient.
+#define BITS_MAX 62
+
+// Inserts a computation into a proof that assigns the given number of low bits of
+// (negate ? -src : src) + offset to the given secret variables, least significant first.
+void computation_bits(proof_t proof, var_t src, int negate, long offset, int count, var_t* bits);
+
+// The number of scratch elements in each field of an instance.
+#define INST_SCRATCH 2
+
+// Identifies the kind of a block in a serialized proof.
+enum block_kind {
+	BLOCK_EQUALS_PUBLIC,
+	BLOCK_EQUALS,
+	BLOCK_WSUM_ZERO,
+	BLOCK_PRODUCT,
+	BLOCK_SIG,
+	BLOCK_ACCUMULATED,
+	BLOCK_INNER_PRODUCT,
+	BLOCK_PRODUCTS,
+	BLOCK_IPA,
+	BLOCK_VECTOR_INNER_PRODUCT,
+	BLOCK_VECTOR_LINEAR,
+	BLOCK_LINEAR_SYSTEM
+};
+
+typedef struct codegen_s *codegen_ptr;
+typedef struct batch_s *batch_ptr;
+
 // A procedure for a proof that verifies some relation between (possibly secret) variables.
+// Blocks may provide a codegen function to emit specialized code for themselves, and a
+// response_verify_batch function to verify every instance of a batch in one pass, which
+// only verifies instances whose valid flag is still set and clears it if they fail.
+// Either may be NULL, in which case the generic functions are used for each instance.
+// A block whose verification is expensive may also split it into verify_steps separate
+// checks, performed one at a time by response_verify_step; otherwise verify_steps is 1 and
+// response_verify_step is NULL.
 typedef struct block_s *block_ptr;
 typedef struct block_s {
 	void (*clear)(block_ptr);
+	int (*write)(block_ptr, proof_t, proof_refs_ptr, FILE*);
+	void (*codegen)(block_ptr, proof_t, codegen_ptr);
 	void (*claim_gen)(block_ptr, proof_t, inst_t, data_ptr, data_ptr);
 	void (*response_gen)(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
 	int (*response_verify)(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr);
+	void (*response_verify_batch)(block_ptr, proof_t, batch_ptr, data_ptr*, data_ptr*, int*);
+	int (*response_verify_step)(block_ptr, proof_t, inst_t, data_ptr, challenge_t, data_ptr, int);
+	int verify_steps;
 	type_ptr supplement_type;
 	type_ptr claim_secret_type;
 	type_ptr claim_public_type;
 	type_ptr response_type;
+	int kind;
 	block_ptr next;
 } block_t[1];
 
+// Identifies one of the per-block parts of the data for a proof.
+enum part {
+	PART_SUPPLEMENT,
+	PART_CLAIM_SECRET,
+	PART_CLAIM_PUBLIC,
+	PART_RESPONSE,
+	PART_COUNT
+};
+
+// Identifies a routine that code is generated for.
+enum codegen_routine {
+	CODEGEN_CLAIM_GEN,
+	CODEGEN_RESPONSE_GEN,
+	CODEGEN_RESPONSE_VERIFY
+};
+
+// Identifies the part of a generated routine that a block is asked to emit. Blocks
+// declare and initialize any temporaries of their own at the top of the routine, emit
+// their work in the body, and clear their temporaries at the end.
+enum codegen_stage {
+	CODEGEN_DECLARE,
+	CODEGEN_BODY,
+	CODEGEN_CLEAR
+};
+
+// The state passed to a block when generating code for it. Generated code addresses data
+// by element index within the whole buffer, starting from base[part] for the block, using
+// the macros CS, CP and RS (claim secret, claim public and response), SUP(offset) for a
+// supplement, and SV, SO, SC and PV for instance values, openings, commitments and public
+// values. It may use the temporaries Z0, Z1 (in the Z field) and G0, G1 (in the G field),
+// and a verifier may jump to the label "invalid" to reject.
+typedef struct codegen_s {
+	FILE* stream;
+	int routine;
+	int stage;
+	int index;
+	size_t base[PART_COUNT];
+} codegen_t[1];
+
+// Describes a block within a finalized proof, along with the types and offsets of its
+// parts of the data for the proof.
+typedef struct plan_entry_s {
+	block_ptr block;
+	int kind;
+	type_ptr types[PART_COUNT];
+	size_t offsets[PART_COUNT];
+} plan_entry_t;
+
+// Gets a data pointer to the part of the given data for a plan entry.
+static inline data_ptr get_block_part(plan_entry_ptr entry, int part, data_ptr data) {
+	return (data_ptr)((char*)data + entry->offsets[part]);
+}
+
 // Inserts a block into a proof.
 void block_insert(proof_t proof, block_ptr block);
 
 // Clears all blocks in a proof.
 void blocks_clear(proof_t proof);
 
+// Reads a block of the given kind from a stream and inserts it into a proof. Returns
+// zero if it is malformed.
+int block_read(proof_t proof, int kind, proof_refs_t refs, FILE* stream);
+
 // Inserts a block into a proof that verifies that a secret variable and a public variable are equivalent.
 void block_equals_public(proof_t proof, long secret_index, long public_index);
 
 // Inserts a block into a proof that verifies a product relationship between three secret variables.
 void block_product(proof_t proof, long product_index, long factor_1_index, long factor_2_index);
 
+// Gets the signature scheme and public key used by a signature block.
+sig_scheme_ptr block_sig_scheme(block_ptr block, data_ptr* public_key);
+
+// Reads a signature block from a stream and inserts it into a proof. Returns zero if
+// it is malformed.
+int block_sig_read(proof_t proof, proof_refs_t refs, FILE* stream);
+
+// Reads an accumulated block from a stream and inserts it into a proof. Returns zero if
+// it is malformed.
+int block_accumulated_read(proof_t proof, proof_refs_t refs, FILE* stream);
+
+// Reads an inner-product argument block from a stream and inserts it into a proof. Returns
+// zero if it is malformed.
+int block_ipa_read(proof_t proof, FILE* stream);
+
+// Reads a vector inner-product or linear block from a stream and inserts it into a proof.
+// Returns zero if it is malformed.
+int block_vector_inner_product_read(proof_t proof, FILE* stream);
+int block_vector_linear_read(proof_t proof, FILE* stream);
+
 #endif // ZKP_INTERNAL_H_
@@ -1,6 +1,8 @@
 #ifndef ZKP_IO_H_
 #define ZKP_IO_H_
 
+#include <stdint.h>
+
 // Writes an element to a stream, returning the number of bytes that were
 // written, or 0, if an error occured.
 size_t element_write(field_ptr field, element_t element, FILE* stream);
@@ -9,6 +11,52 @@ size_t element_write(field_ptr field, element_t element, FILE* stream);
 // read, or 0, if an error occured.
 size_t element_read(field_ptr field, element_t element, FILE* stream);
 
+// Writes an unsigned 64-bit integer to a stream in big-endian order, returning the
+// number of bytes that were written.
+size_t u64_write(uint64_t value, FILE* stream);
+
+// Reads an unsigned 64-bit integer from a stream in big-endian order, returning the
+// number of bytes that were read.
+size_t u64_read(uint64_t* value, FILE* stream);
+
+// Reads an unsigned 64-bit integer from a buffer in big-endian order, returning the
+// number of bytes that were read or READ_INCOMPLETE.
+size_t u64_read_bytes(uint64_t* value, const unsigned char* bytes, size_t size);
+
+// Computes a 64-bit FNV-1a hash of a buffer. This is suitable for detecting corruption,
+// not for resisting deliberate collisions.
+uint64_t hash_bytes(const unsigned char* bytes, size_t size);
+
+// The state of an incremental SHA-256 hash, for deriving values (such as challenges) that
+// must resist deliberate collisions.
+typedef struct sha256_s {
+	uint32_t state[8];
+	uint64_t length;
+	unsigned char block[64];
+	size_t used;
+} sha256_t[1];
+
+// Starts, extends and finishes a SHA-256 hash. The state may be copied to hash several
+// continuations of the same input.
+void sha256_init(sha256_t ctx);
+void sha256_update(sha256_t ctx, const unsigned char* bytes, size_t size);
+void sha256_final(sha256_t ctx, unsigned char digest[32]);
+
+// Returned by in-memory reads when the buffer ends before the value does.
+#define READ_INCOMPLETE ((size_t)-1)
+
+// Returned by in-memory reads when the buffer does not contain a valid value.
+#define READ_ERROR ((size_t)-2)
+
+// Indicates whether the result of an in-memory read is an error or incomplete.
+static inline int read_failed(size_t len) {
+	return len >= READ_ERROR;
+}
+
+// Reads an element from a buffer in the format produced by element_write,
+// returning the number of bytes that were read, READ_INCOMPLETE or READ_ERROR.
+size_t element_read_bytes(field_ptr field, element_t element, const unsigned char* bytes, size_t size);
+
 // A pointer to arbitrary data with a known type.
 typedef void* data_ptr;
 
@@ -20,6 +68,7 @@ typedef struct type_s {
 	void (*copy)(type_ptr, data_ptr, data_ptr);
 	void (*write)(type_ptr, data_ptr, FILE*);
 	void (*read)(type_ptr, data_ptr, FILE*);
+	size_t (*read_bytes)(type_ptr, data_ptr, const unsigned char*, size_t);
 	size_t size;
 } type_t[1];
 
@@ -61,6 +110,12 @@ static inline void read(type_ptr type, data_ptr data, FILE* stream) {
 	type->read(type, data, stream);
 }
 
+// Reads data of the given type from a buffer, returning the number of bytes that
+// were read, READ_INCOMPLETE or READ_ERROR.
+static inline size_t read_bytes(type_ptr type, data_ptr data, const unsigned char* bytes, size_t size) {
+	return type->read_bytes(type, data, bytes, size);
+}
+
 // Describes an element type.
 typedef struct element_type_s *element_type_ptr;
 typedef struct element_type_s {
@@ -0,0 +1,67 @@
+#ifndef ZKP_MEMBER_H_
+#define ZKP_MEMBER_H_
+
+// A public set of values, each signed by the set's owner with a single-value signature
+// scheme. A prover shows that a variable is in the set by proving knowledge of a
+// signature on its value, which costs one signature block however large the set is.
+// The owner holds the secret key and signs each value once, when it is added; the
+// values and their signatures are then published, so that provers can look up the
+// signature on their own value.
+typedef struct member_set_s *member_set_ptr;
+typedef struct member_set_s {
+	
+	// The signature scheme the values are signed with, which signs one value at a time.
+	sig_scheme_t scheme;
+	
+	// The secret key of the set, or NULL if the set was read from its published form.
+	data_ptr secret_key;
+	
+	// The public key of the set.
+	data_ptr public_key;
+	
+	// The values in the set, and their signatures, in the order they were added.
+	int count;
+	int capacity;
+	element_t *values;
+	unsigned char *sigs;
+	
+	// An open-addressed hash table of indices into values, or -1 for empty slots.
+	int *table;
+	size_t table_size;
+	
+} member_set_t[1];
+
+// Initializes an empty set with a new key pair.
+void member_set_init(member_set_t set, pairing_ptr pairing, element_t g);
+
+// Frees the space occupied by a set.
+void member_set_clear(member_set_t set);
+
+// Adds a value to a set, signing it. The set must have its secret key.
+void member_set_add(member_set_t set, element_t value);
+void member_set_add_si(member_set_t set, long int value);
+
+// Gets the index of a value in a set, or -1 if it is not in the set.
+int member_set_find(member_set_t set, element_t value);
+
+// Gets the signature on a value in a set.
+data_ptr member_set_sig(member_set_t set, int index);
+
+// Copies the signature on a value into a supplement for a membership requirement,
+// returning zero if the value is not in the set.
+int member_set_witness(member_set_t set, element_t value, data_ptr sig);
+
+// Writes the published form of a set (its public key, values and signatures) to a stream.
+void member_set_write(member_set_t set, FILE* stream);
+
+// Initializes a set from its published form, without a secret key. Returns zero if the
+// data is malformed, in which case the set is left cleared.
+int member_set_read(member_set_t set, pairing_ptr pairing, element_t g, FILE* stream);
+
+// Requires that a variable is one of the values of a set in the given proof. The
+// supplement must be filled with the signature on the value (see member_set_witness)
+// for each prover instance. To serialize the proof, the set's scheme and public key
+// must be in the references table.
+void require_member(proof_t proof, member_set_t set, supplement_t* sig, var_t var);
+
+#endif // ZKP_MEMBER_H_
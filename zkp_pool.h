@@ -0,0 +1,39 @@
+#ifndef ZKP_POOL_H_
+#define ZKP_POOL_H_
+
+// Statistics for the pooled allocator, summed over all threads.
+typedef struct pool_stats_s *pool_stats_ptr;
+typedef struct pool_stats_s {
+	
+	// The number of allocations that fit a size class.
+	unsigned long long allocs;
+	
+	// The number of those allocations served from a thread's cache.
+	unsigned long long hits;
+	
+	// The number of frees of blocks in a size class.
+	unsigned long long frees;
+	
+	// The number of those frees kept in a thread's cache for reuse.
+	unsigned long long cached;
+	
+	// The number of allocations too large for any size class, which go straight to malloc.
+	unsigned long long large;
+	
+} pool_stats_t[1];
+
+// Installs a pooled allocator for PBC and GMP, which keeps a per-thread cache of freed
+// blocks in a few small size classes so that most element and mpz allocations need
+// neither a call to malloc nor a lock. Blocks may be freed by any thread. This must be
+// called before any PBC or GMP data is allocated, since data allocated by the previous
+// allocator cannot be freed by the pooled one.
+void pool_install(void);
+
+// Gets the statistics of the pooled allocator.
+void pool_stats(pool_stats_t stats);
+
+// Releases the blocks cached by the calling thread back to malloc. This happens
+// automatically when a thread exits.
+void pool_trim(void);
+
+#endif // ZKP_POOL_H_
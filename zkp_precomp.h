@@ -0,0 +1,93 @@
+#ifndef ZKP_PRECOMP_H_
+#define ZKP_PRECOMP_H_
+
+// The number of exponent bits handled by each window of a fixed-base table.
+#define FIXED_BASE_WINDOW 4
+
+// The number of precomputed powers in each window of a fixed-base table.
+#define FIXED_BASE_WINDOW_SIZE ((1 << FIXED_BASE_WINDOW) - 1)
+
+// A table of precomputed powers of a fixed base, allowing it to be raised to any
+// exponent of a bounded size with one multiplication per window and no squarings.
+// Window i holds base ^ (j * 2 ^ (FIXED_BASE_WINDOW * i)) for j = 1 to
+// FIXED_BASE_WINDOW_SIZE.
+typedef struct fixed_base_s *fixed_base_ptr;
+typedef struct fixed_base_s {
+	
+	// The field of the base.
+	field_ptr field;
+	
+	// The number of windows in the table.
+	int windows;
+	
+	// The powers of the base, window by window, or NULL if the table reads them from a
+	// buffer.
+	element_t *powers;
+	
+	// The powers of the base in the format written by fixed_base_write, one slot of
+	// slot_size bytes each, for a table that reads them from a buffer.
+	const unsigned char *bytes;
+	size_t slot_size;
+	
+} fixed_base_t[1];
+
+// Initializes a fixed-base table for exponents with at most the given number of bits.
+void fixed_base_init(fixed_base_t table, element_t base, int bits);
+
+// Frees the space occupied by a fixed-base table.
+void fixed_base_clear(fixed_base_t table);
+
+// Raises the base of a fixed-base table to the given exponent.
+void fixed_base_pow_zn(element_t out, fixed_base_t table, element_t exp);
+
+// Writes a fixed-base table to a stream.
+void fixed_base_write(fixed_base_t table, FILE* stream);
+
+// Initializes a fixed-base table that reads its powers from a buffer in the format written
+// by fixed_base_write, returning the number of bytes that it spans, READ_INCOMPLETE or
+// READ_ERROR. The powers are not copied: each exponentiation decodes the few it needs,
+// so the buffer (such as a mapped cache file) must remain valid while the table is in
+// use. The table is only initialized if the read succeeds.
+size_t fixed_base_init_bytes(fixed_base_t table, field_ptr field, const unsigned char* bytes, size_t size);
+
+// A set of pairing parameters, commitment bases and fixed-base tables loaded from a
+// memory-mapped cache file, so that processes can skip parameter parsing and table
+// generation on start-up. The file is validated by its header, which records its format
+// version, its size and a hash of the parameters it was written for.
+typedef struct cache_s *cache_ptr;
+typedef struct cache_s {
+	
+	// The contents of the cache file.
+	const unsigned char *data;
+	
+	// The size of the cache file in bytes.
+	size_t size;
+	
+	// The pairing described by the cached parameters.
+	pairing_t pairing;
+	
+	// The g element for proofs, used for computing commitments.
+	element_t g;
+	
+	// The h element for proofs, used for computing commitments.
+	element_t h;
+	
+	// The fixed-base tables for g and h.
+	fixed_base_t g_table;
+	fixed_base_t h_table;
+	
+} cache_t[1];
+
+// Writes a cache file for the given pairing parameters (as accepted by pairing_init_set_buf)
+// and commitment bases, computing their fixed-base tables.
+void cache_write(FILE* stream, const char* param, size_t param_size, element_t g, element_t h);
+
+// Opens a cache file from the given path for the given pairing parameters. Returns zero
+// if the file can not be mapped, fails validation, was written for other parameters or
+// is otherwise malformed, in which case it should be written again.
+int cache_open(cache_t cache, const char* path, const char* param, size_t param_size);
+
+// Frees the space occupied by a cache and unmaps its file.
+void cache_close(cache_t cache);
+
+#endif // ZKP_PRECOMP_H_
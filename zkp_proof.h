@@ -1,12 +1,17 @@
-#ifndef ZKP_TYPES_H_
-#define ZKP_TYPES_H_
+#ifndef ZKP_TYPES_H_
+#define ZKP_TYPES_H_
+
+#include <stdint.h>
 
 typedef struct computation_s *computation_ptr;
 typedef struct block_s *block_ptr;
 typedef struct sig_scheme_s *sig_scheme_ptr;
+typedef struct fixed_base_s *fixed_base_ptr;
+typedef struct plan_entry_s *plan_entry_ptr;
+typedef struct secret_vector_s *secret_vector_ptr;
 
 // Describes a zero-knowledge proof.
-typedef struct proof_s *proof_ptr;
+typedef struct proof_s *proof_ptr;
 typedef struct proof_s {
 
 	// The type for elements used as values in this proof.
@@ -19,6 +24,7 @@ typedef struct proof_s {
 	struct multi_type_s {
 		type_t base;
 		type_ptr (*for_block)(block_ptr);
+		int part;
 		proof_ptr proof;
 	} supplement_type, claim_secret_type, claim_public_type, response_type;
 	
@@ -28,11 +34,20 @@ typedef struct proof_s {
 	// The h element for this proof, used for computing commitments.
 	element_t h;
 	
+	// Precomputed tables for g and h, or NULL if they have not been provided.
+	fixed_base_ptr g_table;
+	fixed_base_ptr h_table;
+	
 	// The number of secret variables in this proof.
-	int num_secret;
+	long num_secret;
 	
 	// The number of public variables in this proof.
-	int num_public;
+	long num_public;
+	
+	// The vectors of secret variables in this proof, which are committed to together, in
+	// the order they were declared.
+	long num_vectors;
+	secret_vector_ptr vectors;
 	
 	// The first computation for this proof.
 	computation_ptr first_computation;
@@ -40,9 +55,28 @@ typedef struct proof_s {
 	// The last computation for this proof.
 	computation_ptr last_computation;
 	
+	// The computations of this proof grouped into levels, where each computation only
+	// depends on computations in earlier levels, or NULL if the proof has not been
+	// finalized. Level i consists of the computations from computation_order[level_starts[i]]
+	// up to computation_order[level_starts[i + 1]].
+	computation_ptr *computation_order;
+	int *level_starts;
+	int num_levels;
+	
 	// The first block for this proof.
 	block_ptr first_block;
 	
+	// The number of blocks in this proof, once it is finalized.
+	int num_blocks;
+	
+	// The blocks of this proof in the order their data is laid out, with precomputed
+	// offsets, or NULL if the proof has not been finalized.
+	plan_entry_ptr plan;
+	
+	// The indices of the plan entries in the order they are executed, which groups
+	// blocks of the same kind together.
+	int *plan_order;
+	
 } proof_t[1];
 
 // Initializes a proof, setting it to a default empty state.
@@ -51,10 +85,58 @@ void proof_init(proof_t proof, field_ptr Z, field_ptr G, element_t g, element_t
 // Frees the space occupied by a proof.
 void proof_clear(proof_t proof);
 
+// Freezes the blocks of a proof into a contiguous execution plan with precomputed data
+// offsets, and orders its computations by their dependencies, both of which are used by
+// all later operations on the proof. No blocks or computations may be added to a proof
+// after it is finalized. A finalized proof is frozen: nothing modifies it (or the
+// signature schemes and precomputed tables it refers to) until it is cleared, so it may
+// be shared by any number of threads, provided each uses its own instances. Proving draws
+// randomness from PBC's random source, and so does verifying a block that combines several
+// checks with random weights.
+void proof_finalize(proof_t proof);
+
+// Provides precomputed tables for the g and h elements of a proof, which will be used for
+// all exponentiations of those elements. The tables must remain valid while the proof is
+// in use.
+void proof_set_tables(proof_t proof, fixed_base_ptr g_table, fixed_base_ptr h_table);
+
+// A table of the signature schemes and public keys, and of the accumulators, that a
+// serialized proof may refer to. Signature and accumulator blocks are written as an index
+// into this table, so the same table (or one with equivalent schemes, keys and
+// accumulators at the same positions) must be given when reading.
+typedef struct proof_refs_s *proof_refs_ptr;
+typedef struct proof_refs_s {
+	int count;
+	sig_scheme_ptr *schemes;
+	data_ptr *public_keys;
+	int num_accumulators;
+	struct accumulator_s **accumulators;
+} proof_refs_t[1];
+
+// Writes the description of a proof (its variables, computations and blocks) to a stream.
+// Returns zero if a block refers to a signature scheme, public key or accumulator that is
+// not in the references table, or if writing to the stream fails; the description is
+// then incomplete.
+int proof_write(proof_t proof, proof_refs_t refs, FILE* stream);
+
+// Computes the SHA-256 hash of the description of a proof, as written by proof_write,
+// which identifies its statement. Returns zero if the description can not be written.
+int proof_digest(proof_t proof, proof_refs_t refs, unsigned char digest[32]);
+
+// The largest number of secret or public variables a description may declare, so that a
+// malformed one can not force huge allocations when instances of the proof are created.
+#define PROOF_READ_MAX_VARS ((uint64_t)1 << 24)
+
+// Initializes a proof from a description written by proof_write, without replaying its
+// construction. Returns zero if the description is malformed, in which case the proof
+// is left cleared.
+int proof_read(proof_t proof, field_ptr Z, field_ptr G, proof_refs_t refs, FILE* stream);
+
 // A reference to a proof variable, which may either be secret (set by the 
 // prover on each instance and kept unknown to the verifier) or public (set
-// consistently between the prover and verifier for each instance).
-typedef unsigned long var_t;
+// consistently between the prover and verifier for each instance). The top bit
+// distinguishes secret variables, and the remaining 63 bits hold the index.
+typedef uint64_t var_t;
 
 // A reference to a block-dependent supplement within an instance. Supplements provide
 // information needed to perform certain proofs.
@@ -71,9 +153,45 @@ var_t var_const(proof_t proof, element_t value);
 var_t var_const_mpz(proof_t proof, mpz_t value);
 var_t var_const_si(proof_t proof, long int value);
 
+// A reference to a vector of secret variables in a proof.
+typedef long vec_t;
+
+// Declares a vector of count new secret variables in the given proof, storing them in
+// vars. Rather than one commitment each, the variables of a vector share a single
+// commitment h ^ o * P_0 ^ x_0 * P_1 ^ x_1 * ... over generators of their own, so the
+// verifier receives one element for the whole vector. The variables are set and computed
+// like any other, but their commitment is only brought up to date by inst_update, and
+// they may only be used in the vector blocks (require_vector_*).
+vec_t var_secret_vector(proof_t proof, int count, var_t* vars);
+
 // Requires a multiplicative relationship between the given product and factor variables in the given proof.
 void require_mul(proof_t proof, var_t product, var_t factor_1, var_t factor_2);
 
+// Requires many multiplicative relationships (products[#] = factors_1[#] * factors_2[#]) in
+// the given proof. These share one block, which verifies them all together with a single
+// multi-exponentiation, so this is much cheaper than calling require_mul for each.
+void require_mul_many(proof_t proof, int count, var_t* products, var_t* factors_1, var_t* factors_2);
+
+// Requires that the given product variable is the inner product of the given vectors of
+// variables (x_0 * y_0 + x_1 * y_1 + ...) in the given proof. Unlike a product block per
+// term, no intermediate products are committed to.
+void require_inner_product(proof_t proof, var_t product, int count, var_t* xs, var_t* ys);
+
+// Requires the same relationship as require_inner_product, with an inner-product argument
+// whose claim and response grow with the logarithm of count rather than count itself, and
+// which is verified with a single multi-exponentiation. Proving costs a few times more.
+void require_inner_product_log(proof_t proof, var_t product, int count, var_t* xs, var_t* ys);
+
+// Requires that the given product variable is the inner product of two different vectors
+// of the same length in the given proof. This uses the inner-product argument of
+// require_inner_product_log directly on the vector commitments.
+void require_vector_inner_product(proof_t proof, var_t product, vec_t xs, vec_t ys);
+
+// Requires that the given variable is the weighted sum of a vector (coeffs[0] * x_0 +
+// coeffs[1] * x_1 + ...) in the given proof, with one coefficient for each variable of
+// the vector. This is an inner product with a public vector, proven the same way.
+void require_vector_linear(proof_t proof, var_t sum, vec_t xs, element_t* coeffs);
+
 // Requires that the values of all of the given variables are equivalent in the given proof.
 void require_equal(proof_t proof, int count, /* var_t a, var_t b, */ ...);
 void require_equal_many(proof_t proof, int count, var_t* vars);
@@ -88,6 +206,23 @@ void require_dif(proof_t proof, var_t dif, var_t minuend, var_t subtrahend);
 void require_wsum_zero(proof_t proof, int count, /* long a_coeff, var_t a, long b_coeff, var_t b, */ ...);
 void require_wsum_zero_many(proof_t proof, int count, long* coeffs, var_t* vars);
 
+// Requires the system of linear equations A * x = b in the given proof, where A is the
+// rows by count matrix of coefficients (coeffs[i * count + j] multiplies vars[j] in row
+// i), and b_i is the public variable rhs[i], or zero for every row if rhs is NULL. Zero
+// coefficients are skipped, and rows and count must be positive. The whole system shares
+// one claim and response, and is verified with a single multi-exponentiation over the
+// variables, rather than one wsum_zero block per row.
+void require_linear_system(proof_t proof, int rows, int count, element_t* coeffs, var_t* vars, var_t* rhs);
+
+// Requires that the given variable, as an integer, lies in [0, 2 ^ bits) in the given proof,
+// where bits is at most 62. This costs one product per bit.
+void require_nonneg(proof_t proof, var_t var, int bits);
+
+// Requires that the given variable, as an integer, lies in [low, high] in the given proof,
+// where low is greater than LONG_MIN and high - low is less than 2 ^ 62. This costs two
+// products per bit of high - low.
+void require_range(proof_t proof, var_t var, long low, long high);
+
 // Requires a signature on a set of variables in the given proof.
 void require_sig(proof_t proof, sig_scheme_ptr scheme, data_ptr public_key, supplement_t* sig, /* var_t a, var_t b, */ ...);
 void require_sig_many(proof_t proof, sig_scheme_ptr scheme, data_ptr public_key, supplement_t* sig, var_t* vars);
@@ -110,7 +245,8 @@ typedef struct inst_s {
 	element_t *secret_openings;
 	
 	// The commitments for the secret variables. The verifier must get these from the
-	// prover.
+	// prover. The commitment and opening of a vector are held by its first variable, and
+	// those of its other variables are unused.
 	element_t *secret_commitments;
 	
 	// The values of the public variables.
@@ -119,6 +255,16 @@ typedef struct inst_s {
 	// Block-dependent supplementary instance data.
 	data_ptr supplement_data;
 	
+	// Temporaries used by blocks when generating claims and responses and when verifying,
+	// so that they need not initialize their own on each call. Because of these, an
+	// instance must not be used by more than one thread at a time.
+	element_t *scratch_Z;
+	element_t *scratch_G;
+	
+	// Flags for each secret variable, then each public variable, set when the variable
+	// has changed since the last call to inst_update.
+	unsigned char *dirty;
+	
 } inst_t[1];
 
 // Initializes a prover instance of a proof.
@@ -132,7 +278,8 @@ void inst_clear(proof_t proof, inst_t inst);
 
 // Sets the value of a variable in an instance of a proof. If the variable is
 // secret, a random opening and corresponding commitment will automatically be
-// generated.
+// generated, except for the variables of a vector, whose commitment is regenerated by
+// the next inst_update.
 void inst_var_set(proof_t proof, inst_t inst, var_t var, element_t value);
 void inst_var_set_mpz(proof_t proof, inst_t inst, var_t var, mpz_t value);
 void inst_var_set_si(proof_t proof, inst_t inst, var_t var, long int value);
@@ -146,17 +293,26 @@ void inst_var_write(proof_t proof, inst_t inst, var_t var, FILE* stream);
 // Reads the value of an instance variable from a stream.
 void inst_var_read(proof_t proof, inst_t inst, var_t var, FILE* stream);
 
-// Sets the values of computed variables in an instance.
+// Sets the values of computed variables in an instance. Only computations with an input
+// or output variable that has been set since the last update are applied, so after a few
+// variables change, only the computations and commitments that depend on them are redone.
 void inst_update(proof_t proof, inst_t inst);
 
+// Marks every variable of an instance as changed, so the next update applies every
+// computation. This is needed after values are written directly into the arrays of an
+// instance rather than through inst_var_set.
+void inst_invalidate(proof_t proof, inst_t inst);
+
 // Returns a pointer to a supplement in an instance.
 data_ptr inst_supplement(proof_t proof, inst_t inst, supplement_t supplement);
 
-// Outputs all commitments for secret variables to a stream.
+// Outputs all commitments for secret variables to a stream, with one for each vector.
 void inst_commitments_write(proof_t proof, inst_t inst, FILE* stream);
 
-// Reads all commitments for secret variables from a stream.
-void inst_commitments_read(proof_t proof, inst_t inst, FILE* stream);
+// Reads all commitments for secret variables from a stream, as written above. Returns
+// zero if the stream ends early or holds an element of the wrong size, in which case some
+// commitments may already have been replaced.
+int inst_commitments_read(proof_t proof, inst_t inst, FILE* stream);
 
 // Creates a random claim for an instance of a proof. A succesful response to the claim
 // with a randomly chosen challenge acts as a witness to the validity of the instance.
@@ -171,6 +327,6 @@ void response_gen(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t
 
 // Verifies the consistency of a response, returning zero if it is invalid or some non-zero value if it is
 // valid.
-int response_verify(proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response);
-
-#endif // ZKP_TYPES_H_
+int response_verify(proof_t proof, inst_t inst, data_ptr claim_public, challenge_t challenge, data_ptr response);
+
+#endif // ZKP_TYPES_H_
@@ -0,0 +1,69 @@
+#ifndef ZKP_RESUME_H_
+#define ZKP_RESUME_H_
+
+// The status of a verifier task that has more work to do.
+#define RESUME_PENDING 0
+
+// The status of a verifier task that has verified all blocks.
+#define RESUME_VALID 1
+
+// The status of a verifier task that has found an invalid block.
+#define RESUME_INVALID 2
+
+// The status of a verifier task that was cancelled before it finished.
+#define RESUME_CANCELLED 3
+
+// The status of a verifier task whose deadline passed before it finished.
+#define RESUME_EXPIRED 4
+
+// Verifies a response to a public claim a bounded amount of work at a time, so that a
+// thread can interleave verification of a large proof with other work. Work is counted
+// in steps: one per block, except for blocks that split their verification into several
+// checks (each signature block takes one step per pairing check or commitment check, each
+// inner product block one per opening and one for the product, and each products block
+// one per group of 64 triples). A step is not bounded in general: the linear system and
+// IPA blocks, and the final check of an inner product block, are verified with a single
+// multi-exponentiation whose size grows with the number of variables they involve.
+// The proof must be finalized.
+typedef struct verifier_task_s *verifier_task_ptr;
+typedef struct verifier_task_s {
+	
+	// The inputs to response_verify, which must remain valid while the task is in use.
+	proof_ptr proof;
+	inst_ptr inst;
+	data_ptr claim_public;
+	element_ptr challenge;
+	data_ptr response;
+	
+	// The status of the task.
+	int status;
+	
+	// The position in the plan of the block being verified, and the next step within it.
+	int index;
+	int step;
+	
+	// The time (in seconds, from the monotonic clock) after which the task expires, or
+	// zero if it has no deadline.
+	double deadline;
+	
+	// Set when the task is cancelled, possibly from another thread.
+	int cancelled;
+	
+} verifier_task_t[1];
+
+// Initializes a verifier task for a public claim and response.
+void verifier_task_init(verifier_task_t task, proof_t proof, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response);
+
+// Sets a task to expire the given number of seconds from now.
+void verifier_task_set_deadline(verifier_task_t task, double seconds);
+
+// Cancels a task. This may be called from any thread; the task stops before its next step.
+void verifier_task_cancel(verifier_task_t task);
+
+// Performs at most the given number of steps of a task (and at least one, if it is
+// pending), returning its status afterwards. The deadline and cancellation are checked
+// before each step.
+int verifier_task_run(verifier_task_t task, int budget);
+
+#endif // ZKP_RESUME_H_
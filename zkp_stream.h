@@ -0,0 +1,91 @@
+#ifndef ZKP_STREAM_H_
+#define ZKP_STREAM_H_
+
+// The status of a verifier stream that needs more data.
+#define STREAM_PENDING 0
+
+// The status of a verifier stream that has verified all blocks.
+#define STREAM_VALID 1
+
+// The status of a verifier stream that has found an invalid or malformed block.
+#define STREAM_INVALID 2
+
+// Incrementally verifies a public claim and response, in the format written by
+// write(&proof->claim_public_type, ...) followed by write(&proof->response_type, ...),
+// as bytes arrive. Each block is verified as soon as its response is complete, and the
+// stream rejects as soon as any block fails, or once the data for a claim or response
+// has arrived and is malformed.
+typedef struct verifier_stream_s *verifier_stream_ptr;
+typedef struct verifier_stream_s {
+	
+	// The proof being verified.
+	proof_ptr proof;
+	
+	// The verifier instance being verified.
+	inst_ptr inst;
+	
+	// The challenge the response is for.
+	element_ptr challenge;
+	
+	// The status of the stream.
+	int status;
+	
+	// Bytes that have been received but not yet parsed.
+	unsigned char *buffer;
+	size_t buffer_size;
+	size_t buffer_capacity;
+	
+	// The public claim for all blocks, filled in as it is parsed.
+	data_ptr claim_public;
+	
+	// The block whose claim or response is being parsed, or NULL once the stream
+	// is no longer pending.
+	block_ptr current;
+	
+	// Indicates whether the stream has moved on from claims to responses.
+	int in_response;
+	
+	// The offset of the current block's part of the public claim.
+	size_t claim_offset;
+	
+	// The response for the current block, once the stream is parsing responses.
+	data_ptr response;
+	
+	// The number of bytes the current claim or response takes when written, or zero if
+	// it is not yet known. Parsing waits until this many bytes have been received.
+	size_t wanted;
+	
+} verifier_stream_t[1];
+
+// Initializes a verifier stream for an instance of a proof and a challenge. The
+// instance and challenge must remain valid while the stream is in use.
+void verifier_stream_init(verifier_stream_t stream, proof_t proof, inst_t inst, challenge_t challenge);
+
+// Frees the space occupied by a verifier stream.
+void verifier_stream_clear(verifier_stream_t stream);
+
+// Gives bytes to a verifier stream, parsing and verifying as many blocks as they
+// complete. Returns the status of the stream afterwards.
+int verifier_stream_push(verifier_stream_t stream, const unsigned char* bytes, size_t size);
+
+// Creates a random claim for an instance of a proof like claim_gen, but writes the public
+// claim for each block to a stream as soon as it is generated instead of keeping it, so
+// that only one block's public claim is held in memory at a time. The output is the same
+// as writing the public claim with write(&proof->claim_public_type, ...).
+//
+// These writers only bound the memory used for the public claim and the response. The
+// instance (its secret values, openings and commitments) and the secret claim for every
+// block stay allocated for the whole proof, since blocks may refer to any secret variable
+// and the claim randomness must last until the challenge is known, so the memory needed
+// still grows with the size of the statement. They are not a bounded-memory prover: the
+// claim randomness comes from the process-wide PBC generator, so it cannot be re-derived
+// per block, and a caller needing that must split the statement into several proofs.
+void claim_gen_write(proof_t proof, inst_t inst, data_ptr claim_secret, FILE* stream);
+
+// Creates a response to a claim like response_gen, but writes the response for each block
+// to a stream as soon as it is generated, so that only one block's response is held in
+// memory at a time. The output is the same as writing the response with
+// write(&proof->response_type, ...).
+void response_gen_write(proof_t proof, inst_t inst, data_ptr claim_secret, challenge_t challenge, FILE* stream);
+
+#endif // ZKP_STREAM_H_
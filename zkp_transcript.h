@@ -0,0 +1,76 @@
+#ifndef ZKP_TRANSCRIPT_H_
+#define ZKP_TRANSCRIPT_H_
+
+#include <pthread.h>
+
+// Statistics for a transcript cache.
+typedef struct transcript_stats_s *transcript_stats_ptr;
+typedef struct transcript_stats_s {
+	
+	// The number of verifications answered from the cache.
+	unsigned long long hits;
+	
+	// The number of verifications that were performed and then cached.
+	unsigned long long misses;
+	
+	// The number of entries evicted to stay within the memory limit.
+	unsigned long long evictions;
+	
+	// The number of transcripts too large to cache at all.
+	unsigned long long oversized;
+	
+	// The number of entries currently cached, and the bytes they occupy.
+	size_t count;
+	size_t bytes;
+	
+} transcript_stats_t[1];
+
+// A bounded cache of the results of verifying transcripts for one proof, so that a
+// transcript that is received again (such as a proof retransmitted by a client) need not
+// be verified again. A transcript is everything response_verify depends on besides the
+// proof: the public values and secret commitments of the instance, the public claim, the
+// challenge and the response. Entries are looked up by a hash of the serialized
+// transcript and confirmed by comparing it in full, so a hit only ever returns the
+// result for an identical transcript. The least recently used entries are evicted to
+// keep the cache within its memory limit. A cache may be shared between threads.
+typedef struct transcript_cache_s *transcript_cache_ptr;
+typedef struct transcript_cache_s {
+	
+	// The proof the transcripts are for, which must be finalized.
+	proof_ptr proof;
+	
+	// The maximum number of bytes the entries may occupy.
+	size_t max_bytes;
+	
+	// The hash table of entries.
+	struct transcript_entry_s **buckets;
+	size_t num_buckets;
+	
+	// The entries, from most to least recently used.
+	struct transcript_entry_s *newest;
+	struct transcript_entry_s *oldest;
+	
+	// The statistics of the cache.
+	transcript_stats_t stats;
+	
+	// Guards all of the above.
+	pthread_mutex_t lock;
+	
+} transcript_cache_t[1];
+
+// Initializes an empty transcript cache for a finalized proof, whose entries may occupy
+// at most the given number of bytes.
+void transcript_cache_init(transcript_cache_t cache, proof_t proof, size_t max_bytes);
+
+// Frees the space occupied by a transcript cache.
+void transcript_cache_clear(transcript_cache_t cache);
+
+// Verifies a response as response_verify does, returning the cached result if an
+// identical transcript has been verified before.
+int transcript_cache_verify(transcript_cache_t cache, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response);
+
+// Gets the statistics of a transcript cache.
+void transcript_cache_stats(transcript_cache_t cache, transcript_stats_t stats);
+
+#endif // ZKP_TRANSCRIPT_H_
@@ -0,0 +1,84 @@
+#ifndef ZKP_WORKERS_H_
+#define ZKP_WORKERS_H_
+
+#include <pthread.h>
+
+// A request to verify a response against a public claim. Jobs are owned by the caller,
+// who must keep the job and everything it refers to alive until it completes. A finalized
+// proof (see proof_finalize) is never modified by verification and may be shared by any
+// number of jobs, along with the signature schemes and public keys it refers to, but
+// each job that may run concurrently with another must have its own instance, since
+// instances hold scratch space.
+typedef struct verify_job_s *verify_job_ptr;
+typedef struct verify_job_s {
+	
+	// The inputs to response_verify.
+	proof_ptr proof;
+	inst_ptr inst;
+	data_ptr claim_public;
+	element_ptr challenge;
+	data_ptr response;
+	
+	// A function called on a worker thread when the job completes, or NULL.
+	void (*callback)(verify_job_ptr job, void* arg);
+	void* arg;
+	
+	// The result of response_verify, once the job is done.
+	int result;
+	
+	// Set once the job is done.
+	int done;
+	
+	// The workers the job was submitted to.
+	struct workers_s *workers;
+	
+} verify_job_t[1];
+
+// A pool of threads that verify jobs. Each worker has its own queue of jobs; a worker
+// takes the newest job from its own queue and, when that is empty, steals the oldest job
+// from another worker's queue, so jobs submitted in bursts spread over all workers
+// without a single shared queue.
+typedef struct workers_s *workers_ptr;
+typedef struct workers_s {
+	
+	// The number of worker threads.
+	int count;
+	
+	// The worker threads and their queues.
+	struct worker_s *workers;
+	
+	// The queue the next job submitted from outside the pool is placed on.
+	int next;
+	
+	// The number of jobs submitted but not yet done, and whether the pool is stopping.
+	int pending;
+	int queued;
+	int stopping;
+	
+	// Guards the counters above; signalled when jobs are queued or completed.
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	
+} workers_t[1];
+
+// Initializes a verify job. The callback may be NULL.
+void verify_job_init(verify_job_t job, proof_t proof, inst_t inst, data_ptr claim_public,
+	challenge_t challenge, data_ptr response, void (*callback)(verify_job_ptr, void*), void* arg);
+
+// Waits for a submitted job to complete, returning its result.
+int verify_job_wait(verify_job_t job);
+
+// Starts a pool with the given number of worker threads.
+void workers_init(workers_t workers, int count);
+
+// Waits for all submitted jobs to complete, then stops the pool and frees its space.
+void workers_clear(workers_t workers);
+
+// Submits a job to a pool.
+void workers_submit(workers_t workers, verify_job_t job);
+
+// Waits for all jobs submitted to a pool to complete.
+void workers_wait(workers_t workers);
+
+#endif // ZKP_WORKERS_H_